@@ -0,0 +1,375 @@
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "./../include/triangles.hpp"
+#include "./../include/octree.hpp"
+#include "./../include/reorder.hpp"
+
+// Every benchmark runs over a fixed set of pairs falling into one branch of
+// check_intersection, so the branch predictor cannot learn a single pair.
+
+const std::size_t NUM_PAIRS = 1024;
+
+using pair_array_t = std::vector<std::pair<triangle_t, triangle_t>>;
+
+static std::mt19937 gen (42);
+
+static double random (double min, double max)
+{
+    return std::uniform_real_distribution<double> (min, max) (gen);
+}
+
+static point_t random_point (double min, double max, double z_min, double z_max)
+{
+    return { random (min, max), random (min, max), random (z_min, z_max) };
+}
+
+static triangle_t random_line (double z)
+{
+    point_t p = random_point (0, 1, z, z);
+    point_t d = random_point (-0.5, 0.5, 0, 0);
+    return { p, p + d, p + d * 2 };
+}
+
+static triangle_t random_tr_point ()
+{
+    point_t p = random_point (0, 1, 0, 0);
+    return { p, p, p };
+}
+
+// pairs from generate are kept only if keep (pair) is true
+template <typename G, typename K>
+static pair_array_t generate_pairs (G generate, K keep)
+{
+    pair_array_t pairs {};
+    while (pairs.size () < NUM_PAIRS)
+    {
+        std::pair<triangle_t, triangle_t> pair = generate ();
+        if (keep (pair))
+            pairs.push_back (pair);
+    }
+    return pairs;
+}
+
+static bool general_position (const std::pair<triangle_t, triangle_t>& pair)
+{
+    const triangle_t& tr1 = pair.first;
+    const triangle_t& tr2 = pair.second;
+    return (!tr1.degenerate_tr () && !tr2.degenerate_tr () &&
+            !tr1.check_same_sign_distance (tr2) && !tr2.check_same_sign_distance (tr1) &&
+            !tr1.get_N ().cross_product (tr2.get_N ()).zero_vector ());
+}
+
+static pair_array_t separated_pairs ()
+{
+    return generate_pairs ([] () -> std::pair<triangle_t, triangle_t>
+    {
+        return { { random_point (0, 1, 0, 0.1), random_point (0, 1, 0, 0.1), random_point (0, 1, 0, 0.1) },
+                 { random_point (0, 1, 5, 5.1), random_point (0, 1, 5, 5.1), random_point (0, 1, 5, 5.1) } };
+    },
+    [] (const std::pair<triangle_t, triangle_t>& pair) { return pair.second.check_same_sign_distance (pair.first); });
+}
+
+static pair_array_t general_pairs ()
+{
+    return generate_pairs ([] () -> std::pair<triangle_t, triangle_t>
+    {
+        return { { random_point (0, 1, -0.1, 0.1), random_point (0, 1, -0.1, 0.1), random_point (0, 1, -0.1, 0.1) },
+                 { random_point (0, 1, 0.5, 1), random_point (0, 1, 0.5, 1), random_point (0, 1, -1, -0.5) } };
+    }, general_position);
+}
+
+static pair_array_t coplanar_pairs ()
+{
+    return generate_pairs ([] () -> std::pair<triangle_t, triangle_t>
+    {
+        return { { random_point (0, 1, 0, 0), random_point (0, 1, 0, 0), random_point (0, 1, 0, 0) },
+                 { random_point (0, 1, 0, 0), random_point (0, 1, 0, 0), random_point (0, 1, 0, 0) } };
+    },
+    [] (const std::pair<triangle_t, triangle_t>& pair)
+    {
+        return !pair.first.degenerate_tr () && !pair.second.degenerate_tr ();
+    });
+}
+
+static pair_array_t line_line_pairs ()
+{
+    return generate_pairs ([] () -> std::pair<triangle_t, triangle_t> { return { random_line (0), random_line (0) }; },
+                           [] (const std::pair<triangle_t, triangle_t>& pair)
+                           {
+                               return pair.first.triangle_is_line () && pair.second.triangle_is_line ();
+                           });
+}
+
+static pair_array_t line_point_pairs ()
+{
+    return generate_pairs ([] () -> std::pair<triangle_t, triangle_t> { return { random_line (0), random_tr_point () }; },
+                           [] (const std::pair<triangle_t, triangle_t>& pair) { return pair.first.triangle_is_line (); });
+}
+
+static pair_array_t point_point_pairs ()
+{
+    return generate_pairs ([] () -> std::pair<triangle_t, triangle_t> { return { random_tr_point (), random_tr_point () }; },
+                           [] (const std::pair<triangle_t, triangle_t>&) { return true; });
+}
+
+static void set_pair_counters (benchmark::State& state, std::size_t num_pairs)
+{
+    double pairs = static_cast<double> (state.iterations ()) * num_pairs;
+    state.counters["pairs/s"] = benchmark::Counter (pairs, benchmark::Counter::kIsRate);
+    state.counters["s/pair"]  = benchmark::Counter (pairs, benchmark::Counter::kIsRate |
+                                                           benchmark::Counter::kInvert);
+}
+
+// ------------------------------CHECK_INTERSECTION----------------------------------
+
+static void check_intersection (benchmark::State& state, pair_array_t (*make_pairs) (), kernel_t kernel)
+{
+    pair_array_t pairs = make_pairs ();
+    for (auto _ : state)
+    {
+        for (const auto& pair : pairs)
+        {
+            benchmark::DoNotOptimize (pair.first.check_intersection (pair.second, kernel));
+        }
+    }
+    set_pair_counters (state, pairs.size ());
+}
+
+BENCHMARK_CAPTURE (check_intersection, separated, separated_pairs, kernel_t::epsilon);
+BENCHMARK_CAPTURE (check_intersection, general_position, general_pairs, kernel_t::epsilon);
+BENCHMARK_CAPTURE (check_intersection, coplanar, coplanar_pairs, kernel_t::epsilon);
+BENCHMARK_CAPTURE (check_intersection, line_line, line_line_pairs, kernel_t::epsilon);
+BENCHMARK_CAPTURE (check_intersection, line_point, line_point_pairs, kernel_t::epsilon);
+BENCHMARK_CAPTURE (check_intersection, point_point, point_point_pairs, kernel_t::epsilon);
+
+BENCHMARK_CAPTURE (check_intersection, separated_robust, separated_pairs, kernel_t::robust);
+BENCHMARK_CAPTURE (check_intersection, general_position_robust, general_pairs, kernel_t::robust);
+BENCHMARK_CAPTURE (check_intersection, coplanar_robust, coplanar_pairs, kernel_t::robust);
+BENCHMARK_CAPTURE (check_intersection, line_line_robust, line_line_pairs, kernel_t::robust);
+BENCHMARK_CAPTURE (check_intersection, line_point_robust, line_point_pairs, kernel_t::robust);
+BENCHMARK_CAPTURE (check_intersection, point_point_robust, point_point_pairs, kernel_t::robust);
+
+BENCHMARK_CAPTURE (check_intersection, separated_gd, separated_pairs, kernel_t::guigue_devillers);
+BENCHMARK_CAPTURE (check_intersection, general_position_gd, general_pairs, kernel_t::guigue_devillers);
+BENCHMARK_CAPTURE (check_intersection, coplanar_gd, coplanar_pairs, kernel_t::guigue_devillers);
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------HELPERS---------------------------------------------
+
+static void projection (benchmark::State& state)
+{
+    pair_array_t pairs = general_pairs ();
+    for (auto _ : state)
+    {
+        for (const auto& pair : pairs)
+        {
+            benchmark::DoNotOptimize (pair.first.projection ('x', pair.second));
+        }
+    }
+    set_pair_counters (state, pairs.size ());
+}
+
+BENCHMARK (projection);
+
+static void distance_point_plane_tr (benchmark::State& state)
+{
+    pair_array_t pairs = general_pairs ();
+    for (auto _ : state)
+    {
+        for (const auto& pair : pairs)
+        {
+            benchmark::DoNotOptimize (pair.first.distance_point_plane_tr (pair.second.get_a ()));
+        }
+    }
+    set_pair_counters (state, pairs.size ());
+}
+
+BENCHMARK (distance_point_plane_tr);
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------BOUNDING_CUBE---------------------------------------
+
+static std::vector<triangle_t> random_triangles (std::size_t N)
+{
+    std::vector<triangle_t> array_triangle {};
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        point_t p = random_point (-100, 100, -100, 100);
+        array_triangle.push_back ({ p, p + random_point (0, 1, 0, 1), p + random_point (0, 1, 0, 1) });
+    }
+    return array_triangle;
+}
+
+static void count_bounding_cube (benchmark::State& state)
+{
+    std::vector<triangle_t> array_triangle = random_triangles (state.range (0));
+
+    octree_t tree (array_triangle);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize (tree.count_bounding_cube ());
+    }
+    state.counters["triangles/s"] = benchmark::Counter (static_cast<double> (state.iterations ()) * state.range (0),
+                                                        benchmark::Counter::kIsRate);
+}
+
+BENCHMARK (count_bounding_cube)->Arg (1 << 12)->Arg (1 << 16)->Arg (1 << 20);
+
+static void count_bounding_cube_parallel (benchmark::State& state)
+{
+    std::vector<triangle_t> array_triangle = random_triangles (state.range (0));
+
+    thread_pool_t pool {};
+    octree_t tree (array_triangle, pool);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize (tree.count_bounding_cube (pool));
+    }
+    state.counters["triangles/s"] = benchmark::Counter (static_cast<double> (state.iterations ()) * state.range (0),
+                                                        benchmark::Counter::kIsRate);
+}
+
+BENCHMARK (count_bounding_cube_parallel)->Arg (1 << 12)->Arg (1 << 16)->Arg (1 << 20)->UseRealTime ();
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------BUILD_TRIANGLES-------------------------------------
+
+static std::vector<double> random_coords (std::size_t N)
+{
+    std::vector<double> coords (9 * N);
+    for (auto& tmp : coords)
+        tmp = random (-100, 100);
+    return coords;
+}
+
+static void build_triangles_constructor (benchmark::State& state)
+{
+    std::vector<double> coords = random_coords (state.range (0));
+    for (auto _ : state)
+    {
+        std::vector<triangle_t> array_triangle {};
+        array_triangle.reserve (state.range (0));
+        for (std::size_t i = 0; i < coords.size (); i += 9)
+        {
+            array_triangle.push_back ({ { coords[i],     coords[i + 1], coords[i + 2] },
+                                        { coords[i + 3], coords[i + 4], coords[i + 5] },
+                                        { coords[i + 6], coords[i + 7], coords[i + 8] } });
+        }
+        benchmark::DoNotOptimize (array_triangle.data ());
+    }
+    state.counters["triangles/s"] = benchmark::Counter (static_cast<double> (state.iterations ()) * state.range (0),
+                                                        benchmark::Counter::kIsRate);
+}
+
+BENCHMARK (build_triangles_constructor)->Arg (1 << 16);
+
+static void build_triangles_pool (benchmark::State& state)
+{
+    std::vector<double> coords = random_coords (state.range (0));
+    thread_pool_t pool {};
+    for (auto _ : state)
+    {
+        std::vector<triangle_t> array_triangle = build_triangles (coords, pool);
+        benchmark::DoNotOptimize (array_triangle.data ());
+    }
+    state.counters["triangles/s"] = benchmark::Counter (static_cast<double> (state.iterations ()) * state.range (0),
+                                                        benchmark::Counter::kIsRate);
+}
+
+BENCHMARK (build_triangles_pool)->Arg (1 << 16)->UseRealTime ();
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------SCALAR_TYPES----------------------------------------
+
+// the whole query, building the tree included, on the same scene in every type
+template <typename T>
+static void self_intersection (benchmark::State& state)
+{
+    std::vector<basic_triangle_t<T>> array_triangle {};
+    for (const auto& tr : random_triangles (state.range (0)))
+    {
+        auto convert = [] (const point_t& p) { return basic_point_t<T> (p.x_, p.y_, p.z_); };
+        array_triangle.push_back ({ convert (tr.get_a ()), convert (tr.get_b ()), convert (tr.get_c ()) });
+    }
+
+    thread_pool_t pool {};
+    for (auto _ : state)
+    {
+        basic_octree_t<T> tree (array_triangle, pool);
+        benchmark::DoNotOptimize (tree.get_num_tr_intersection (pool));
+    }
+    state.counters["triangles/s"] = benchmark::Counter (static_cast<double> (state.iterations ()) * state.range (0),
+                                                        benchmark::Counter::kIsRate);
+}
+
+BENCHMARK_TEMPLATE (self_intersection, float)->Arg (1 << 18)->UseRealTime ();
+BENCHMARK_TEMPLATE (self_intersection, double)->Arg (1 << 18)->UseRealTime ();
+BENCHMARK_TEMPLATE (self_intersection, long double)->Arg (1 << 18)->UseRealTime ();
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------REORDER---------------------------------------------
+
+// the whole query on the triangles in the random order of random_triangles and
+// renumbered along the Morton curve, the renumbering included
+static void self_intersection_order (benchmark::State& state)
+{
+    std::vector<triangle_t> array_triangle = random_triangles (state.range (0));
+    bool reorder = state.range (1);
+
+    thread_pool_t pool {};
+    for (auto _ : state)
+    {
+        std::vector<triangle_t> copy = array_triangle;
+        std::vector<std::size_t> order {};
+        if (reorder)
+            order = reorder_morton (copy, pool);
+
+        octree_t tree (copy, pool);
+        std::vector<unsigned char> flags = tree.get_intersection_flags (pool);
+        if (reorder)
+            flags = restore_order (flags, order);
+        benchmark::DoNotOptimize (flags);
+    }
+    state.counters["triangles/s"] = benchmark::Counter (static_cast<double> (state.iterations ()) * state.range (0),
+                                                        benchmark::Counter::kIsRate);
+}
+
+BENCHMARK (self_intersection_order)->ArgsProduct ({ { 1 << 18, 1 << 20 }, { 0, 1 } })->UseRealTime ()
+                                   ->Unit (benchmark::kMillisecond);
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------GATHER----------------------------------------------
+
+// the verification of a built tree, the pairs of a leaf checked through the indices
+// and on the leaf buffer
+static void self_intersection_gather (benchmark::State& state)
+{
+    std::vector<triangle_t> array_triangle = random_triangles (state.range (0));
+    thread_pool_t pool {};
+    reorder_morton (array_triangle, pool);
+
+    octree_t tree (array_triangle, pool);
+    tree.set_gather_leaves (state.range (1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize (tree.get_intersection_flags (pool));
+
+    state.counters["triangles/s"] = benchmark::Counter (static_cast<double> (state.iterations ()) * state.range (0),
+                                                        benchmark::Counter::kIsRate);
+}
+
+BENCHMARK (self_intersection_gather)->ArgsProduct ({ { 1 << 18, 1 << 20 }, { 0, 1 } })->UseRealTime ()
+                                    ->Unit (benchmark::kMillisecond);
+
+// ----------------------------------------------------------------------------------
+
+BENCHMARK_MAIN ();
@@ -0,0 +1,219 @@
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./../include/octree.hpp"
+#include "./../include/thread_pool.hpp"
+#include "scene_generator.hpp"
+
+// End-to-end scaling driver. Every (distribution, N, threads) run is done in a forked
+// child process, so the peak RSS of one run is not hidden by the previous ones.
+//
+//   scaling [--min-n N] [--max-n N] [--threads 1,2,4] [--distributions uniform,slivers]
+//           [--seed S] [--json]
+//   scaling --generate DISTRIBUTION N [SEED]   prints a scene in the input format of the main program
+
+struct run_t
+{
+    distribution_t distribution = distribution_t::uniform;
+    std::size_t N = 0;
+    std::size_t threads = 1;
+};
+
+struct options_t
+{
+    std::size_t min_n = 1000;
+    std::size_t max_n = 10000000;
+    std::vector<std::size_t> threads {};
+    std::vector<distribution_t> distributions {};
+    std::uint64_t seed = 1;
+    bool json = false;
+};
+
+static std::vector<std::string> split (const std::string& str)
+{
+    std::vector<std::string> parts {};
+    std::size_t begin = 0;
+    while (begin <= str.size ())
+    {
+        std::size_t end = str.find (',', begin);
+        if (end == std::string::npos)
+            end = str.size ();
+        parts.push_back (str.substr (begin, end - begin));
+        begin = end + 1;
+    }
+    return parts;
+}
+
+static void measure (const run_t& run, const options_t& options)
+{
+    std::vector<triangle_t> array_triangle = scene_generator_t (options.seed).generate (run.distribution, run.N);
+    thread_pool_t pool (run.threads);
+
+    auto start = std::chrono::steady_clock::now ();
+    octree_t tree (array_triangle);
+    double build_ms = milliseconds_since (start);
+
+    start = std::chrono::steady_clock::now ();
+    std::set<std::size_t> num_tr = tree.get_num_tr_intersection (pool);
+    double query_ms = milliseconds_since (start);
+
+    struct rusage usage {};
+    getrusage (RUSAGE_SELF, &usage);
+
+    std::string name = distribution_name (run.distribution);
+    std::size_t candidate_pairs = tree.count_candidate_pairs ();
+
+    if (options.json)
+    {
+        std::cout << "{\"distribution\": \"" << name << "\", \"n\": " << run.N
+                  << ", \"threads\": " << run.threads << ", \"build_ms\": " << build_ms
+                  << ", \"query_ms\": " << query_ms << ", \"peak_rss_kb\": " << usage.ru_maxrss
+                  << ", \"candidate_pairs\": " << candidate_pairs
+                  << ", \"intersecting\": " << num_tr.size () << "}";
+    }
+    else
+    {
+        std::cout << name << "," << run.N << "," << run.threads << "," << build_ms << "," << query_ms << ","
+                  << usage.ru_maxrss << "," << candidate_pairs << "," << num_tr.size () << "\n";
+    }
+    std::cout.flush ();
+
+#ifdef TRIANGLES_PROFILE
+    std::cerr << name << " " << run.N << " " << run.threads << "\n";
+    branch_profile_t::instance ().print (std::cerr);
+#endif
+}
+
+static int generate (int argc, char* argv[])
+{
+    distribution_t distribution {};
+    if (argc < 4 || !distribution_from_name (argv[2], distribution))
+    {
+        std::cerr << "usage: scaling --generate DISTRIBUTION N [SEED]\n";
+        return 1;
+    }
+
+    std::size_t N = std::strtoull (argv[3], nullptr, 10);
+    std::uint64_t seed = (argc > 4) ? std::strtoull (argv[4], nullptr, 10) : 1;
+
+    std::vector<triangle_t> array_triangle = scene_generator_t (seed).generate (distribution, N);
+
+    std::cout.precision (17);
+    std::cout << N << "\n";
+    for (const auto& tr : array_triangle)
+    {
+        for (const point_t& p : { tr.get_a (), tr.get_b (), tr.get_c () })
+            std::cout << p.x_ << " " << p.y_ << " " << p.z_ << " ";
+        std::cout << "\n";
+    }
+    return 0;
+}
+
+static bool parse_options (int argc, char* argv[], options_t& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = (i + 1 < argc);
+
+        if (arg == "--json")
+            options.json = true;
+        else if (arg == "--min-n" && has_value)
+            options.min_n = std::strtoull (argv[++i], nullptr, 10);
+        else if (arg == "--max-n" && has_value)
+            options.max_n = std::strtoull (argv[++i], nullptr, 10);
+        else if (arg == "--seed" && has_value)
+            options.seed = std::strtoull (argv[++i], nullptr, 10);
+        else if (arg == "--threads" && has_value)
+        {
+            for (const auto& part : split (argv[++i]))
+                options.threads.push_back (std::strtoull (part.c_str (), nullptr, 10));
+        }
+        else if (arg == "--distributions" && has_value)
+        {
+            for (const auto& part : split (argv[++i]))
+            {
+                distribution_t distribution {};
+                if (!distribution_from_name (part, distribution))
+                {
+                    std::cerr << "unknown distribution " << part << "\n";
+                    return false;
+                }
+                options.distributions.push_back (distribution);
+            }
+        }
+        else
+        {
+            std::cerr << "unknown option " << arg << "\n";
+            return false;
+        }
+    }
+
+    if (options.threads.empty ())
+    {
+        std::size_t max_threads = std::max (std::thread::hardware_concurrency (), 1u);
+        for (std::size_t threads = 1; threads < max_threads; threads *= 2)
+            options.threads.push_back (threads);
+        options.threads.push_back (max_threads);
+    }
+
+    if (options.distributions.empty ())
+        options.distributions.assign (std::begin (ALL_DISTRIBUTIONS), std::end (ALL_DISTRIBUTIONS));
+
+    return true;
+}
+
+int main (int argc, char* argv[])
+{
+    if (argc > 1 && std::strcmp (argv[1], "--generate") == 0)
+        return generate (argc, argv);
+
+    options_t options {};
+    if (!parse_options (argc, argv, options))
+        return 1;
+
+    std::vector<run_t> runs {};
+    for (auto distribution : options.distributions)
+        for (std::size_t N = options.min_n; N <= options.max_n; N *= 10)
+            for (auto threads : options.threads)
+                runs.push_back ({ distribution, N, threads });
+
+    if (options.json)
+        std::cout << "[\n";
+    else
+        std::cout << "distribution,n,threads,build_ms,query_ms,peak_rss_kb,candidate_pairs,intersecting\n";
+    std::cout.flush ();
+
+    for (std::size_t i = 0; i < runs.size (); ++i)
+    {
+        if (options.json && i != 0)
+        {
+            std::cout << ",\n";
+            std::cout.flush ();
+        }
+
+        pid_t pid = fork ();
+        if (pid == 0)
+        {
+            measure (runs[i], options);
+            std::_Exit (0);
+        }
+
+        int status = 0;
+        waitpid (pid, &status, 0);
+        if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+            std::cerr << "run " << distribution_name (runs[i].distribution) << " " << runs[i].N << " failed\n";
+    }
+
+    if (options.json)
+        std::cout << "\n]\n";
+}
@@ -0,0 +1,176 @@
+#ifndef SCENE_GENERATOR_HPP
+#define SCENE_GENERATOR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "./../include/triangles.hpp"
+
+// Scenes depend only on (distribution, N, seed). std::mt19937_64 is fully specified
+// by the standard, the std::*_distribution classes are not, so the conversion to
+// doubles is done here to give the same scene with every standard library.
+
+enum class distribution_t
+{
+    uniform,    // small triangles spread over the space
+    clustered,  // small triangles in gaussian blobs
+    slivers,    // long thin triangles
+    coplanar,   // triangles lying on a few parallel sheets
+    degenerate, // a third of points and a third of segments
+    far_away    // uniform, shifted far from the origin
+};
+
+const distribution_t ALL_DISTRIBUTIONS[] = { distribution_t::uniform,    distribution_t::clustered,
+                                             distribution_t::slivers,    distribution_t::coplanar,
+                                             distribution_t::degenerate, distribution_t::far_away };
+
+const double PI = 3.14159265358979323846;
+const double SCENE_HALF_SIDE = 100.0;
+const double FAR_AWAY_SHIFT  = 1e6;
+const std::size_t NUM_SHEETS = 4;
+const std::size_t TRIANGLES_IN_CLUSTER = 1000;
+const double CLUSTER_SIGMA = SCENE_HALF_SIDE / 50;
+
+inline std::string distribution_name (distribution_t distribution)
+{
+    switch (distribution)
+    {
+        case distribution_t::uniform:    return "uniform";
+        case distribution_t::clustered:  return "clustered";
+        case distribution_t::slivers:    return "slivers";
+        case distribution_t::coplanar:   return "coplanar";
+        case distribution_t::degenerate: return "degenerate";
+        case distribution_t::far_away:   return "far_away";
+    }
+    return "unknown";
+}
+
+inline bool distribution_from_name (const std::string& name, distribution_t& distribution)
+{
+    for (auto tmp : ALL_DISTRIBUTIONS)
+    {
+        if (distribution_name (tmp) == name)
+        {
+            distribution = tmp;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ------------------------------SCENE_GENERATOR_T-----------------------------------
+
+class scene_generator_t
+{
+private:
+    std::mt19937_64 gen_;
+
+    double uniform (double min, double max) { return min + (max - min) * ((gen_ () >> 11) * 0x1.0p-53); }
+    double gaussian (double sigma);
+    point_t uniform_point (double half_side)
+    {
+        return { uniform (-half_side, half_side), uniform (-half_side, half_side), uniform (-half_side, half_side) };
+    }
+    triangle_t small_triangle (const point_t& p, double size);
+
+public:
+    explicit scene_generator_t (std::uint64_t seed) : gen_ (seed) { };
+
+    std::vector<triangle_t> generate (distribution_t distribution, std::size_t N);
+};
+
+// Box-Muller transform
+inline double scene_generator_t::gaussian (double sigma)
+{
+    double u1 = uniform (0, 1);
+    double u2 = uniform (0, 1);
+    return sigma * std::sqrt (-2 * std::log (1 - u1)) * std::cos (2 * PI * u2);
+}
+
+inline triangle_t scene_generator_t::small_triangle (const point_t& p, double size)
+{
+    return { p, p + uniform_point (size), p + uniform_point (size) };
+}
+
+// The triangle size shrinks as N^(-1/3), so the expected number of neighbours of
+// a triangle does not depend on N.
+inline std::vector<triangle_t> scene_generator_t::generate (distribution_t distribution, std::size_t N)
+{
+    double size = SCENE_HALF_SIDE / std::cbrt (static_cast<double> (std::max<std::size_t> (N, 1)));
+    std::size_t num_cluster = std::max<std::size_t> (N / TRIANGLES_IN_CLUSTER, 1);
+
+    std::vector<point_t> clusters {};
+    for (std::size_t i = 0; i < num_cluster && distribution == distribution_t::clustered; ++i)
+        clusters.push_back (uniform_point (SCENE_HALF_SIDE));
+
+    std::vector<triangle_t> array_triangle {};
+    array_triangle.reserve (N);
+
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        switch (distribution)
+        {
+            case distribution_t::uniform:
+                array_triangle.push_back (small_triangle (uniform_point (SCENE_HALF_SIDE), size));
+                break;
+
+            case distribution_t::clustered:
+            {
+                std::size_t num = static_cast<std::size_t> (uniform (0, num_cluster));
+                const point_t& center = clusters[std::min (num, num_cluster - 1)];
+                point_t p = center + point_t (gaussian (CLUSTER_SIGMA), gaussian (CLUSTER_SIGMA),
+                                              gaussian (CLUSTER_SIGMA));
+                array_triangle.push_back (small_triangle (p, CLUSTER_SIGMA / std::cbrt (TRIANGLES_IN_CLUSTER)));
+                break;
+            }
+
+            case distribution_t::slivers:
+            {
+                point_t p = uniform_point (SCENE_HALF_SIDE);
+                point_t d = uniform_point (SCENE_HALF_SIDE / 5);
+                array_triangle.push_back ({ p, p + d, p + d / 2 + uniform_point (size / 100) });
+                break;
+            }
+
+            case distribution_t::coplanar:
+            {
+                double z = -SCENE_HALF_SIDE + 2 * SCENE_HALF_SIDE * (i % NUM_SHEETS + 1) / (NUM_SHEETS + 1);
+                point_t p (uniform (-SCENE_HALF_SIDE, SCENE_HALF_SIDE), uniform (-SCENE_HALF_SIDE, SCENE_HALF_SIDE), z);
+                point_t d1 (uniform (-size, size), uniform (-size, size), 0);
+                point_t d2 (uniform (-size, size), uniform (-size, size), 0);
+                array_triangle.push_back ({ p, p + d1, p + d2 });
+                break;
+            }
+
+            case distribution_t::degenerate:
+            {
+                point_t p = uniform_point (SCENE_HALF_SIDE);
+                point_t d = uniform_point (size);
+                if (i % 3 == 0)
+                    array_triangle.push_back ({ p, p, p });
+                else if (i % 3 == 1)
+                    array_triangle.push_back ({ p, p + d, p + d * 2 });
+                else
+                    array_triangle.push_back (small_triangle (p, size));
+                break;
+            }
+
+            case distribution_t::far_away:
+            {
+                point_t shift (FAR_AWAY_SHIFT, FAR_AWAY_SHIFT, FAR_AWAY_SHIFT);
+                array_triangle.push_back (small_triangle (uniform_point (SCENE_HALF_SIDE) + shift, size));
+                break;
+            }
+        }
+    }
+
+    return array_triangle;
+}
+
+// ----------------------------------------------------------------------------------
+
+#endif // SCENE_GENERATOR_HPP
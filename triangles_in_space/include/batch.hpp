@@ -0,0 +1,57 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <vector>
+
+#include "thread_pool.hpp"
+#include "triangles.hpp"
+#include "octree.hpp"
+#include "engine.hpp"
+
+// a scene of at least BATCH_SPLIT_MIN_TRIANGLES triangles is verified on the whole
+// pool, the smaller ones are verified one per task
+const std::size_t BATCH_SPLIT_MIN_TRIANGLES = 20000;
+
+// ------------------------------BATCH-----------------------------------------------
+
+// flags[i] is get_intersection_flags of scenes[i], the engine of every scene is selected
+// by engine and calibration. The large scenes are verified one after another, each one
+// on the whole pool (the naive loop of one runs on the calling thread). The small ones
+// are taken by the threads of the pool from a shared counter, the largest first, so
+// that a thread that got a large scene does not hold the others back.
+template <typename T>
+std::vector<std::vector<unsigned char>> get_batch_intersection_flags (
+    std::vector<std::vector<basic_triangle_t<T>>>& scenes, thread_pool_t& pool, kernel_t kernel = DEFAULT_KERNEL,
+    engine_t engine = engine_t::automatic, const engine_calibration_t& calibration = {})
+{
+    std::vector<std::vector<unsigned char>> flags (scenes.size ());
+
+    std::vector<std::size_t> order (scenes.size ());
+    std::iota (order.begin (), order.end (), 0);
+    std::stable_sort (order.begin (), order.end (), [&] (std::size_t a, std::size_t b)
+    {
+        return scenes[a].size () > scenes[b].size ();
+    });
+
+    std::size_t num_large = 0;
+    for (; num_large < order.size () && scenes[order[num_large]].size () >= BATCH_SPLIT_MIN_TRIANGLES; ++num_large)
+    {
+        flags[order[num_large]] = get_intersection_flags (scenes[order[num_large]], pool, engine, calibration, kernel);
+    }
+
+    std::atomic<std::size_t> next { num_large };
+    pool.parallel_for (0, pool.get_num_threads (), [&] (std::size_t)
+    {
+        for (std::size_t i = next++; i < order.size (); i = next++)
+            flags[order[i]] = get_intersection_flags (scenes[order[i]], engine, calibration, kernel);
+    });
+
+    return flags;
+}
+
+// ----------------------------------------------------------------------------------
+
+#endif // BATCH_HPP
@@ -0,0 +1,229 @@
+#ifndef ENGINE_HPP
+#define ENGINE_HPP
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "thread_pool.hpp"
+#include "triangles.hpp"
+#include "octree.hpp"
+
+// scenes of at most NAIVE_MAX_TRIANGLES triangles are verified by the O(N^2) loop
+// unless a calibration says otherwise, building the tree costs more than it saves
+// for them
+const std::size_t NAIVE_MAX_TRIANGLES = 128;
+
+// the calibration scans N = CALIBRATION_MIN_N, 2 * CALIBRATION_MIN_N, ... up to
+// CALIBRATION_MAX_N, every measurement is repeated for CALIBRATION_MIN_NS
+const std::size_t CALIBRATION_MIN_N = 16;
+const std::size_t CALIBRATION_MAX_N = 4096;
+const double CALIBRATION_MIN_NS = 2e6;
+const std::size_t CALIBRATION_NUM_ROUNDS = 3;
+
+// ------------------------------ENGINE_T--------------------------------------------
+
+// the algorithm of a self-intersection query; automatic is naive for the scenes
+// of at most naive_max_triangles_ triangles and octree for the others
+enum class engine_t { octree, naive, automatic };
+
+const engine_t ALL_ENGINES[] = { engine_t::octree, engine_t::naive, engine_t::automatic };
+
+// "octree", "naive", "auto"; defined in src/engine.cpp
+std::string engine_name (engine_t engine);
+bool engine_from_name (const std::string& name, engine_t& engine);
+
+struct engine_calibration_t
+{
+    std::size_t naive_max_triangles_ = NAIVE_MAX_TRIANGLES;
+};
+
+// The calibration file holds the line "naive_max_triangles N". False if the file
+// cannot be read or written; calibration is not changed then.
+bool load_calibration (const std::string& path, engine_calibration_t& calibration);
+bool save_calibration (const std::string& path, const engine_calibration_t& calibration);
+
+inline engine_t select_engine (engine_t engine, std::size_t num_triangles, const engine_calibration_t& calibration)
+{
+    if (engine != engine_t::automatic)
+        return engine;
+
+    return (num_triangles <= calibration.naive_max_triangles_) ? engine_t::naive : engine_t::octree;
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------NAIVE-----------------------------------------------
+
+// The loop of every pair, the bounding boxes are compared first; they are copied
+// into one array, a pair that does not overlap never touches the triangles. Boxes
+// are widened by kernel_margin, farther than which the kernel reports no pair, so
+// the result is the one of check_intersection over every pair.
+template <typename T>
+std::vector<unsigned char> get_intersection_flags_naive (const std::vector<basic_triangle_t<T>>& array_triangle,
+                                                         kernel_t kernel = DEFAULT_KERNEL)
+{
+    T margin = kernel_margin<T> (kernel);
+
+    std::size_t N = array_triangle.size ();
+    std::vector<std::array<T, 6>> boxes (N);
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        const basic_point_t<T>& p_min = array_triangle[i].get_p_min ();
+        const basic_point_t<T>& p_max = array_triangle[i].get_p_max ();
+        boxes[i] = { p_min.x_ - margin, p_min.y_ - margin, p_min.z_ - margin,
+                     p_max.x_ + margin, p_max.y_ + margin, p_max.z_ + margin };
+    }
+
+    std::vector<unsigned char> flags (N);
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        const std::array<T, 6> box = boxes[i];
+        for (std::size_t j = i + 1; j < N; ++j)
+        {
+            const std::array<T, 6>& other = boxes[j];
+            if (box[3] < other[0] || other[3] < box[0] || box[4] < other[1] || other[4] < box[1] ||
+                box[5] < other[2] || other[5] < box[2])
+                continue;
+
+            if (array_triangle[i].check_intersection (array_triangle[j], kernel))
+            {
+                flags[i] = 1;
+                flags[j] = 1;
+            }
+        }
+    }
+    return flags;
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------SELECTION-------------------------------------------
+
+// one thread
+template <typename T>
+std::vector<unsigned char> get_intersection_flags (std::vector<basic_triangle_t<T>>& array_triangle,
+                                                   engine_t engine, const engine_calibration_t& calibration,
+                                                   kernel_t kernel = DEFAULT_KERNEL)
+{
+    if (select_engine (engine, array_triangle.size (), calibration) == engine_t::naive)
+        return get_intersection_flags_naive (array_triangle, kernel);
+
+    basic_octree_t<T> tree (array_triangle);
+    tree.set_kernel (kernel);
+    return tree.get_intersection_flags ();
+}
+
+// the tree is built and verified on pool, the naive loop runs on the calling thread
+template <typename T>
+std::vector<unsigned char> get_intersection_flags (std::vector<basic_triangle_t<T>>& array_triangle,
+                                                   thread_pool_t& pool, engine_t engine,
+                                                   const engine_calibration_t& calibration,
+                                                   kernel_t kernel = DEFAULT_KERNEL)
+{
+    if (select_engine (engine, array_triangle.size (), calibration) == engine_t::naive)
+        return get_intersection_flags_naive (array_triangle, kernel);
+
+    basic_octree_t<T> tree (array_triangle, pool);
+    tree.set_kernel (kernel);
+    return tree.get_intersection_flags (pool);
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------CALIBRATION-----------------------------------------
+
+// N triangles of size about 1 spread uniformly with the same density for every N,
+// a small part of a mesh
+template <typename T>
+std::vector<basic_triangle_t<T>> calibration_scene (std::size_t N, unsigned seed)
+{
+    std::mt19937 gen (seed);
+    T space = T (2) * std::cbrt (static_cast<T> (N));
+    std::uniform_real_distribution<T> pos (-space, space);
+    std::uniform_real_distribution<T> offset (T (-1), T (1));
+
+    std::vector<basic_triangle_t<T>> array_triangle;
+    array_triangle.reserve (N);
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        basic_point_t<T> p (pos (gen), pos (gen), pos (gen));
+        basic_point_t<T> b (p.x_ + offset (gen), p.y_ + offset (gen), p.z_ + offset (gen));
+        basic_point_t<T> c (p.x_ + offset (gen), p.y_ + offset (gen), p.z_ + offset (gen));
+        array_triangle.push_back ({ p, b, c });
+    }
+    return array_triangle;
+}
+
+// nanoseconds of one call of get_intersection_flags, the best of the rounds
+template <typename T>
+double measure_engine (std::vector<basic_triangle_t<T>>& array_triangle, engine_t engine, kernel_t kernel)
+{
+    engine_calibration_t calibration {};
+    double best = INFINITY;
+    for (std::size_t round = 0; round < CALIBRATION_NUM_ROUNDS; ++round)
+    {
+        std::size_t num_calls = 0;
+        double elapsed = 0;
+        auto start = std::chrono::steady_clock::now ();
+        while (elapsed < CALIBRATION_MIN_NS / CALIBRATION_NUM_ROUNDS)
+        {
+            get_intersection_flags (array_triangle, engine, calibration, kernel);
+            num_calls++;
+            elapsed = std::chrono::duration<double, std::nano> (std::chrono::steady_clock::now () - start).count ();
+        }
+        best = std::min (best, elapsed / num_calls);
+    }
+    return best;
+}
+
+// Measures both engines on calibration scenes of doubling N and bisects between
+// the last N where the naive loop is faster and the first one where it is not.
+// Takes some tens of milliseconds.
+template <typename T>
+engine_calibration_t calibrate_engine (kernel_t kernel = DEFAULT_KERNEL)
+{
+    auto naive_is_faster = [&] (std::size_t N)
+    {
+        std::vector<basic_triangle_t<T>> array_triangle = calibration_scene<T> (N, static_cast<unsigned> (N));
+        return measure_engine (array_triangle, engine_t::naive, kernel) <=
+               measure_engine (array_triangle, engine_t::octree, kernel);
+    };
+
+    std::size_t low = 0; // the naive loop is faster up to low
+    std::size_t high = CALIBRATION_MIN_N;
+    while (high <= CALIBRATION_MAX_N && naive_is_faster (high))
+    {
+        low = high;
+        high *= 2;
+    }
+
+    engine_calibration_t calibration {};
+    if (high > CALIBRATION_MAX_N)
+    {
+        calibration.naive_max_triangles_ = CALIBRATION_MAX_N;
+        return calibration;
+    }
+
+    // bisection in steps of an eighth of the interval
+    std::size_t step = std::max<std::size_t> ((high - low) / 8, 1);
+    while (high - low > step)
+    {
+        std::size_t middle = low + (high - low) / 2;
+        if (naive_is_faster (middle))
+            low = middle;
+        else
+            high = middle;
+    }
+
+    calibration.naive_max_triangles_ = low;
+    return calibration;
+}
+
+// ----------------------------------------------------------------------------------
+
+#endif // ENGINE_HPP
@@ -0,0 +1,166 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "thread_pool.hpp"
+#include "triangles.hpp"
+#include "octree.hpp"
+#include "partition.hpp"
+
+// ------------------------------NUMA_TOPOLOGY_T-------------------------------------
+
+// cpus_[node] are the cpus of the node this process may run on
+struct numa_topology_t
+{
+    std::vector<std::vector<int>> cpus_ {};
+
+    std::size_t get_num_nodes () const { return cpus_.size (); }
+};
+
+// Defined in src/numa.cpp. The nodes of /sys/devices/system/node, or one node of
+// all the allowed cpus if there is no such directory.
+numa_topology_t detect_numa_topology ();
+// the allowed cpus split into num_nodes nodes of consecutive cpus, a node gets no
+// cpus if there are fewer cpus than nodes; for testing on a machine of one node
+numa_topology_t simulated_numa_topology (std::size_t num_nodes);
+// restricts the calling thread to cpus; false if cpus is empty or the call fails
+bool pin_current_thread (const std::vector<int>& cpus);
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------NUMA_POOL_T-----------------------------------------
+
+// One thread_pool_t per node, its workers are pinned to the cpus of the node. The
+// threads are shared equally by the nodes.
+class numa_pool_t
+{
+private:
+    numa_topology_t topology_;
+    std::vector<std::unique_ptr<thread_pool_t>> pools_ {};
+
+public:
+    explicit numa_pool_t (const numa_topology_t& topology,
+                          std::size_t num_threads = std::thread::hardware_concurrency ());
+
+    std::size_t get_num_nodes () const { return topology_.get_num_nodes (); }
+    const numa_topology_t& get_topology () const { return topology_; }
+    thread_pool_t& get_pool (std::size_t node) { return *pools_[node]; }
+
+    // Calls func (node, pool of the node) for every node at the same time, each one on
+    // a new thread pinned to the node. Memory first written inside func is placed on
+    // the node by the first touch policy of the kernel.
+    template <typename F>
+    void for_each_node (F func);
+};
+
+inline numa_pool_t::numa_pool_t (const numa_topology_t& topology, std::size_t num_threads) : topology_(topology)
+{
+    if (topology_.cpus_.empty ())
+        topology_.cpus_.emplace_back ();
+
+    std::size_t num_nodes = topology_.get_num_nodes ();
+    std::size_t threads_per_node = std::max<std::size_t> (num_threads / num_nodes, 1);
+    for (const auto& cpus : topology_.cpus_)
+        pools_.push_back (std::make_unique<thread_pool_t> (threads_per_node, [cpus] { pin_current_thread (cpus); }));
+}
+
+template <typename F>
+void numa_pool_t::for_each_node (F func)
+{
+    std::vector<std::thread> threads {};
+    for (std::size_t node = 0; node < get_num_nodes (); ++node)
+    {
+        threads.emplace_back ([this, &func, node]
+        {
+            pin_current_thread (topology_.cpus_[node]);
+            func (node, *pools_[node]);
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join ();
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------NUMA_VERIFICATION-----------------------------------
+
+// Flags as get_intersection_flags of the octree with one tree per node. The space is
+// cut into slabs of partition.hpp, one per node. The triangles of a slab are built
+// from coords on their node, into memory first written there, and verified by the
+// workers of the node; their leaf buffers (set_gather_leaves) are thread_local, and
+// so on the node too. node_stats, if given, gets the statistics of the tree of every node.
+template <typename T>
+std::vector<unsigned char> get_numa_intersection_flags (const std::vector<T>& coords, numa_pool_t& numa_pool,
+                                                        kernel_t kernel = DEFAULT_KERNEL, bool gather_leaves = false,
+                                                        std::vector<octree_stats_t>* node_stats = nullptr)
+{
+    std::size_t N = coords.size () / 9;
+    std::size_t num_nodes = numa_pool.get_num_nodes ();
+    std::vector<std::vector<T>> centers {};
+    for (std::size_t num = 0; num < N; num += std::max<std::size_t> (N / PARTITION_SAMPLE_SIZE, 1))
+        add_slab_sample (coords.data () + 9 * num, centers);
+
+    int axis = 0;
+    std::vector<T> bounds = slab_bounds (centers, num_nodes, axis);
+    T margin = kernel_margin<T> (kernel);
+
+    std::vector<std::vector<std::size_t>> hits (num_nodes);
+    if (node_stats)
+        node_stats->assign (num_nodes, octree_stats_t {});
+    numa_pool.for_each_node ([&] (std::size_t node, thread_pool_t& pool)
+    {
+        std::size_t num_blocks = (N + BUILD_BLOCK_SIZE - 1) / BUILD_BLOCK_SIZE;
+        std::vector<std::vector<std::size_t>> nums_in_block (num_blocks);
+        pool.parallel_for (0, num_blocks, [&] (std::size_t block)
+        {
+            std::size_t end = std::min ((block + 1) * BUILD_BLOCK_SIZE, N);
+            for (std::size_t num = block * BUILD_BLOCK_SIZE; num < end; ++num)
+            {
+                std::pair<std::size_t, std::size_t> slabs = slab_range (coords.data () + 9 * num, axis, margin, bounds);
+                if (slabs.first <= node && node <= slabs.second)
+                    nums_in_block[block].push_back (num);
+            }
+        });
+
+        std::vector<std::size_t> nums {};
+        for (const auto& block : nums_in_block)
+            nums.insert (nums.end (), block.begin (), block.end ());
+
+        std::vector<basic_triangle_t<T>> array_triangle (nums.size ());
+        pool.parallel_for (0, nums.size (), [&] (std::size_t i)
+        {
+            const T* v = coords.data () + 9 * nums[i];
+            array_triangle[i] = basic_triangle_t<T> ({ v[0], v[1], v[2] }, { v[3], v[4], v[5] },
+                                                     { v[6], v[7], v[8] });
+        });
+
+        basic_octree_t<T> tree (array_triangle, pool);
+        tree.set_kernel (kernel);
+        tree.set_gather_leaves (gather_leaves);
+        std::vector<unsigned char> flags = tree.get_intersection_flags (pool);
+        for (std::size_t i = 0; i < flags.size (); ++i)
+        {
+            if (flags[i])
+                hits[node].push_back (nums[i]);
+        }
+        if (node_stats)
+            (*node_stats)[node] = tree.get_stats ();
+    });
+
+    std::vector<unsigned char> flags (N);
+    for (const auto& node_hits : hits)
+    {
+        for (auto num : node_hits)
+            flags[num] = 1;
+    }
+    return flags;
+}
+
+// ----------------------------------------------------------------------------------
+
+#endif // NUMA_HPP
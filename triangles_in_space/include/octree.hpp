@@ -1,11 +1,17 @@
 #ifndef OCTREE_HPP
 #define OCTREE_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
 #include <set>
 #include <vector>
 #include <array>
 #include <limits>
 
+#include "thread_pool.hpp"
 #include "triangles.hpp"
 
 const double MAX_DOUBLE = std::numeric_limits<double>::max();
@@ -13,115 +19,387 @@ const double MIN_DOUBLE = -std::numeric_limits<double>::max();
 const std::size_t OPTIMAL_NUM_TR_IN_SPACE = 15;
 const std::size_t MAX_VALUE_DEEP_RECURSION = 6;
 const std::size_t OCTREE_CHILD_COUNT = 8;
+// leaves of at most LEAF_BUFFER_CAPACITY triangles are gathered into a leaf buffer
+const std::size_t LEAF_BUFFER_CAPACITY = 64;
+const std::size_t CACHE_LINE_SIZE = 64;
 
 // ------------------------------NODE_T----------------------------------------------
 
-class node_t
+template <typename T>
+class basic_node_t
 {
 private:
+    basic_point_t<T> p_min_ {};
+    basic_point_t<T> p_max_ {};
     std::vector<std::size_t> num_triangles_in_same_space_ {};
+    std::vector<basic_node_t*> children_ {}; // not owned, the tree deletes all nodes
 
 public:
-    node_t (const std::vector<std::size_t>& num_tr) : num_triangles_in_same_space_(num_tr) {};
+    basic_node_t (const basic_point_t<T>& p1, const basic_point_t<T>& p2);
+    basic_node_t (const basic_point_t<T>& p1, const basic_point_t<T>& p2, const std::vector<std::size_t>& num_tr) :
+        basic_node_t (p1, p2) { num_triangles_in_same_space_ = num_tr; };
+
     std::vector<std::size_t>& get_num_triangles () { return num_triangles_in_same_space_; }
+    const std::vector<std::size_t>& get_num_triangles () const { return num_triangles_in_same_space_; }
+    const std::vector<basic_node_t*>& get_children () const { return children_; }
+    void add_child (basic_node_t* child) { children_.push_back (child); }
+    bool is_leaf () const { return children_.empty (); }
+
+    basic_point_t<T> get_p_min () const { return p_min_; }
+    basic_point_t<T> get_p_max () const { return p_max_; }
+};
+
+template <typename T>
+inline basic_node_t<T>::basic_node_t (const basic_point_t<T>& p1, const basic_point_t<T>& p2)
+{
+    p_min_ = basic_point_t<T> (std::min (p1.x_, p2.x_), std::min (p1.y_, p2.y_), std::min (p1.z_, p2.z_));
+    p_max_ = basic_point_t<T> (std::max (p1.x_, p2.x_), std::max (p1.y_, p2.y_), std::max (p1.z_, p2.z_));
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------RAY_HIT_T-------------------------------------------
+
+template <typename T>
+struct basic_ray_hit_t
+{
+    bool hit_ = false;
+    std::size_t num_tr_ = 0;
+    T t_ = INFINITY;
+};
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------LEAF_BUFFER_T---------------------------------------
+
+// Copies of the triangles of one leaf and their bounding boxes, split by coordinate.
+// The pair loop of a gathered leaf reads only this buffer, which stays in L1: the
+// boxes reject most pairs, the kernels read the contiguous copies.
+template <typename T>
+struct basic_leaf_buffer_t
+{
+    std::size_t size_ = 0;
+    bool in_use_ = false; // a callback may query the tree again on the same thread
+    alignas (CACHE_LINE_SIZE) T min_x_[LEAF_BUFFER_CAPACITY];
+    alignas (CACHE_LINE_SIZE) T min_y_[LEAF_BUFFER_CAPACITY];
+    alignas (CACHE_LINE_SIZE) T min_z_[LEAF_BUFFER_CAPACITY];
+    alignas (CACHE_LINE_SIZE) T max_x_[LEAF_BUFFER_CAPACITY];
+    alignas (CACHE_LINE_SIZE) T max_y_[LEAF_BUFFER_CAPACITY];
+    alignas (CACHE_LINE_SIZE) T max_z_[LEAF_BUFFER_CAPACITY];
+    alignas (CACHE_LINE_SIZE) basic_triangle_t<T> triangles_[LEAF_BUFFER_CAPACITY];
+};
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------OCTREE_STATS_T--------------------------------------
+
+struct octree_stats_t
+{
+    std::size_t num_triangles_ = 0;
+    std::size_t num_leaves_ = 0;
+    std::size_t min_tr_in_leaf_ = 0;
+    std::size_t max_tr_in_leaf_ = 0;
+    std::size_t p99_tr_in_leaf_ = 0;
+    double avg_tr_in_leaf_ = 0;
+    double duplication_factor_ = 0; // sum of leaf sizes / number of triangles
+    std::vector<std::size_t> depth_histogram_ {}; // number of leaves at depth i, the root has depth 0
+    std::size_t num_cut_leaves_ = 0; // leaves stopped by MAX_VALUE_DEEP_RECURSION
+
+    std::size_t num_pair_tests_ = 0;
+    std::size_t num_hits_ = 0;
+
+    double bounding_cube_ms_ = 0;
+    double build_ms_ = 0;
+    double verify_ms_ = 0;
 };
 
+// defined in src/octree.cpp
+std::ostream& operator<< (std::ostream& out, const octree_stats_t& stats);
+
 // ----------------------------------------------------------------------------------
 
 // ------------------------------OCTREE_T--------------------------------------------
 
-class octree_t
+template <typename T>
+class basic_octree_t
 {
+public:
+    using point_t    = basic_point_t<T>;
+    using vector_t   = basic_vector_t<T>;
+    using ray_t      = basic_ray_t<T>;
+    using triangle_t = basic_triangle_t<T>;
+    using node_t     = basic_node_t<T>;
+    using ray_hit_t  = basic_ray_hit_t<T>;
+
+    // A triangle goes into every cube its box, widened by LEAF_MARGIN, touches, so
+    // every pair a kernel may report (kernel_margin) shares a leaf. The tree is built
+    // before the kernel is set, the margin is the one of the epsilon kernel.
+    static constexpr T LEAF_MARGIN = kernel_margin<T> (kernel_t::epsilon);
+
 private:
     std::vector<triangle_t>& array_triangle_;
+    std::vector<node_t*> array_node_tree_ {}; // owns every node, the root is the first one
     std::vector<node_t*> array_leaf_tree_ {};
-    std::set<std::size_t> num_tr_intersection_ {};   
+    kernel_t kernel_ = DEFAULT_KERNEL;
+    bool gather_leaves_ = false;
+
+    std::vector<std::size_t> depth_histogram_ {};
+    std::size_t num_cut_leaves_ = 0;
+    double bounding_cube_ms_ = 0;
+    double build_ms_ = 0;
+    mutable std::atomic<std::size_t> num_pair_tests_ { 0 };
+    mutable std::atomic<std::size_t> num_hits_ { 0 };
+    mutable std::atomic<std::int64_t> verify_ns_ { 0 };
 
-    double count_bounding_cube ();
-    double nearest_power_of_two (double num);
-    void recursive_construction_tree (const point_t& p_min, const point_t& p_max,
-                                      std::vector<std::size_t>& num_triangles, int dep);
+    static T nearest_power_of_two (T num);
+    T max_abs_coordinate (std::size_t begin, std::size_t end) const;
+    void construction (T max_coordinate);
+    node_t* recursive_construction_tree (const point_t& p_min, const point_t& p_max,
+                                         std::vector<std::size_t>& num_triangles, int dep);
 
-    void naive_verification (std::vector<std::size_t>& num1);  
+    template <typename F>
+    bool naive_verification (const node_t* leaf, F& callback) const;
+    template <typename F>
+    bool gathered_verification (const node_t* leaf, F& callback) const;
+    static basic_leaf_buffer_t<T>& leaf_buffer ();
+    template <typename F>
+    bool query_triangle (const node_t* node, const triangle_t& tr, F& callback) const;
+    bool leaf_owns_pair (const node_t* leaf, const triangle_t& tr1, const triangle_t& tr2) const;
+    bool leaf_owns_pair (const node_t* leaf, const point_t& p_min_1, const point_t& p_max_1,
+                         const point_t& p_min_2, const point_t& p_max_2) const;
+    bool leaf_owns_overlap (const node_t* leaf, const point_t& p_min_1, const point_t& p_max_1,
+                            const point_t& p_min_2, const point_t& p_max_2) const;
+    template <typename P, typename F>
+    bool range_traversal (const node_t* node, const point_t& p_min, const point_t& p_max,
+                          P& predicate, F& callback) const;
+    void nearest_traversal (const node_t* node, const triangle_t& tr, std::size_t& num_tr,
+                            T& min_distance) const;
+    static T distance_box_box (const point_t& p_min_1, const point_t& p_max_1,
+                                    const point_t& p_min_2, const point_t& p_max_2);
+    template <bool any_hit>
+    void ray_traversal (const node_t* node, const ray_t& ray, ray_hit_t& hit) const;
+    static bool ray_cross_cube (const ray_t& ray, const point_t& p_min, const point_t& p_max,
+                                T& t_enter);
 
 public:
-    octree_t (std::vector<triangle_t>& array_triangle);
-    ~octree_t() { for (auto& tmp : array_leaf_tree_) { delete tmp; } };
+    basic_octree_t (std::vector<triangle_t>& array_triangle);
+    // the preparation passes over all triangles are run on pool
+    basic_octree_t (std::vector<triangle_t>& array_triangle, thread_pool_t& pool);
+    ~basic_octree_t() { for (auto& tmp : array_node_tree_) { delete tmp; } };
+
+    // the narrow phase of every intersection query
+    void set_kernel (kernel_t kernel) { kernel_ = kernel; }
+    kernel_t get_kernel () const { return kernel_; }
+    // the pairs of every leaf of at most LEAF_BUFFER_CAPACITY triangles are checked
+    // on a per-thread basic_leaf_buffer_t; its box filter rejects only the pairs the
+    // kernel rejects by boxes_near, the result is the same
+    void set_gather_leaves (bool gather) { gather_leaves_ = gather; }
+    bool get_gather_leaves () const { return gather_leaves_; }
+
+    // half side of the cube centered at the origin holding every triangle
+    T count_bounding_cube () const;
+    T count_bounding_cube (thread_pool_t& pool) const;
+
+    // callback (num_1, num_2) is called once for every intersecting pair as soon as
+    // it is found, num_1 < num_2; returning false stops the search.
+    // Returns false if the search was stopped by callback.
+    template <typename F>
+    bool for_each_intersecting_pair (F callback) const;
+    // callback (num) for every triangle of the tree intersecting tr
+    template <typename F>
+    bool for_each_intersecting_pair (const triangle_t& tr, F callback) const;
 
-    std::set<std::size_t> get_num_tr_intersection ();
+    std::size_t get_intersecting_pairs (std::pair<std::size_t, std::size_t>* buffer,
+                                        std::size_t buffer_size) const;
+    bool has_intersection () const;
+
+    std::set<std::size_t> get_num_tr_intersection () const;
+    std::set<std::size_t> get_num_tr_intersection (thread_pool_t& pool) const;
+    std::set<std::size_t> get_num_tr_intersection (const triangle_t& tr) const;
+    // flags[num] is 1 if the triangle num intersects another one, 0 otherwise
+    std::vector<unsigned char> get_intersection_flags () const;
+    std::vector<unsigned char> get_intersection_flags (thread_pool_t& pool) const;
+
+    // number of pairs sharing a leaf, i.e. the work of the naive verification
+    std::size_t count_candidate_pairs () const;
+    // pair tests, hits and verify time are accumulated over all the queries
+    octree_stats_t get_stats () const;
+
+    // triangles whose bounding box overlaps the box with opposite corners p1, p2
+    template <typename F>
+    bool for_each_triangle_in_box (const point_t& p1, const point_t& p2, F callback) const;
+    // triangles having at least one point inside the sphere
+    template <typename F>
+    bool for_each_triangle_in_sphere (const point_t& center, T radius, F callback) const;
+
+    std::vector<std::size_t> get_num_tr_in_box (const point_t& p1, const point_t& p2) const;
+    std::vector<std::size_t> get_num_tr_in_sphere (const point_t& center, T radius) const;
+    std::vector<std::vector<std::size_t>> get_num_tr_in_box (
+        const std::vector<std::pair<point_t, point_t>>& boxes, thread_pool_t& pool) const;
+    std::vector<std::vector<std::size_t>> get_num_tr_in_sphere (
+        const std::vector<std::pair<point_t, T>>& spheres, thread_pool_t& pool) const;
+
+    // nearest triangle of the tree closer than max_distance, INFINITY if there is none
+    T get_min_distance (const triangle_t& tr, std::size_t& num_tr,
+                             T max_distance = INFINITY) const;
+    // callback (num, distance) for every triangle of the tree not farther than distance from tr
+    template <typename F>
+    bool for_each_triangle_within_distance (const triangle_t& tr, T distance, F callback) const;
+
+    ray_hit_t get_first_hit (const ray_t& ray) const;
+    ray_hit_t get_any_hit (const ray_t& ray) const;
+    std::vector<ray_hit_t> get_first_hit (const std::vector<ray_t>& rays, thread_pool_t& pool) const;
+    std::vector<ray_hit_t> get_any_hit (const std::vector<ray_t>& rays, thread_pool_t& pool) const;
 };
 
-inline octree_t::octree_t (std::vector<triangle_t>& array_triangle) : array_triangle_(array_triangle)
+inline double milliseconds_since (std::chrono::steady_clock::time_point start)
 {
-    double max_coordinate = count_bounding_cube ();
+    return std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now () - start).count ();
+}
+
+// The first num_child children of a traversal by distance, an insertion sort as
+// std::sort does for so few. std::sort itself on the fixed array makes GCC 12 warn
+// (-Warray-bounds) about its path for more than 16 elements.
+template <typename T, typename U>
+inline void sort_children (std::array<std::pair<T, U>, OCTREE_CHILD_COUNT>& array_child, std::size_t num_child)
+{
+    for (std::size_t i = 1; i < num_child; ++i)
+    {
+        std::pair<T, U> child = array_child[i];
+        std::size_t j = i;
+        for (; j > 0 && child.first < array_child[j - 1].first; --j)
+            array_child[j] = array_child[j - 1];
+        array_child[j] = child;
+    }
+}
+
+template <typename T>
+inline basic_octree_t<T>::basic_octree_t (std::vector<triangle_t>& array_triangle) : array_triangle_(array_triangle)
+{
+    auto start = std::chrono::steady_clock::now ();
+    T max_coordinate = count_bounding_cube ();
+    bounding_cube_ms_ = milliseconds_since (start);
+
+    construction (max_coordinate);
+}
+
+template <typename T>
+inline basic_octree_t<T>::basic_octree_t (std::vector<triangle_t>& array_triangle, thread_pool_t& pool) :
+    array_triangle_(array_triangle)
+{
+    auto start = std::chrono::steady_clock::now ();
+    T max_coordinate = count_bounding_cube (pool);
+    bounding_cube_ms_ = milliseconds_since (start);
+
+    construction (max_coordinate);
+}
+
+template <typename T>
+inline void basic_octree_t<T>::construction (T max_coordinate)
+{
+    auto start = std::chrono::steady_clock::now ();
 
     point_t p_max = point_t (max_coordinate, max_coordinate, max_coordinate);
     point_t p_min = point_t (-max_coordinate, -max_coordinate, -max_coordinate);
 
     std::vector<std::size_t> num_triangles{};
-    for (std::size_t i = 0; i < array_triangle.size(); i++)
+    for (std::size_t i = 0; i < array_triangle_.size(); i++)
     {
         num_triangles.push_back (i);
     }
 
     recursive_construction_tree (p_min, p_max, num_triangles, 0);
+    build_ms_ = milliseconds_since (start);
 }
 
-inline double octree_t::count_bounding_cube ()
+template <typename T>
+inline T basic_octree_t<T>::count_bounding_cube () const
 {
-    point_t p_min {MAX_DOUBLE, MAX_DOUBLE, MAX_DOUBLE};
-    point_t p_max {MIN_DOUBLE, MIN_DOUBLE, MIN_DOUBLE};
-    for (const auto &tr : array_triangle_) 
+    return nearest_power_of_two (max_abs_coordinate (0, array_triangle_.size ()));
+}
+
+template <typename T>
+inline T basic_octree_t<T>::count_bounding_cube (thread_pool_t& pool) const
+{
+    std::size_t num_chunks = pool.get_num_threads () * CHUNKS_PER_THREAD;
+    std::size_t chunk_size = (array_triangle_.size () + num_chunks - 1) / num_chunks;
+
+    std::vector<T> chunk_max (num_chunks, 0);
+    pool.parallel_for (0, num_chunks, [&] (std::size_t i)
     {
-        const point_t verts[] = { tr.get_a(), tr.get_b(), tr.get_c() };
-        for (const auto &v : verts)
-        {
-            p_min.x_ = std::min(p_min.x_, v.x_);
-            p_min.y_ = std::min(p_min.y_, v.y_);
-            p_min.z_ = std::min(p_min.z_, v.z_);
+        std::size_t begin = std::min (i * chunk_size, array_triangle_.size ());
+        std::size_t end   = std::min (begin + chunk_size, array_triangle_.size ());
+        chunk_max[i] = max_abs_coordinate (begin, end);
+    });
 
-            p_max.y_ = std::max(p_max.y_, v.y_);
-            p_max.x_ = std::max(p_max.x_, v.x_);
-            p_max.z_ = std::max(p_max.z_, v.z_);
-        }
-    }
+    return nearest_power_of_two (*std::max_element (chunk_max.begin (), chunk_max.end ()));
+}
 
-    double max_coordinate = std::max (std::fabs (p_min.x_), std::fabs (p_max.x_));
-    max_coordinate = std::max (max_coordinate, std::max (std::fabs (p_min.y_), std::fabs (p_max.y_)));
-    max_coordinate = std::max (max_coordinate, std::max (std::fabs (p_min.z_), std::fabs (p_max.z_)));
+// Largest absolute coordinate of the cached bounding boxes, the vertices are not touched.
+// Three independent accumulators, one per axis, keep the maxima off one dependency chain.
+template <typename T>
+inline T basic_octree_t<T>::max_abs_coordinate (std::size_t begin, std::size_t end) const
+{
+    T max_x = 0;
+    T max_y = 0;
+    T max_z = 0;
 
-    max_coordinate = nearest_power_of_two (max_coordinate);
+    const triangle_t* array = array_triangle_.data ();
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        const point_t& p_min = array[i].get_p_min ();
+        const point_t& p_max = array[i].get_p_max ();
 
-    return max_coordinate;
+        max_x = std::max (max_x, std::max (-p_min.x_, p_max.x_));
+        max_y = std::max (max_y, std::max (-p_min.y_, p_max.y_));
+        max_z = std::max (max_z, std::max (-p_min.z_, p_max.z_));
+    }
+
+    return std::max (max_x, std::max (max_y, max_z));
 }
 
-inline double octree_t::nearest_power_of_two (double num)
+template <typename T>
+inline T basic_octree_t<T>::nearest_power_of_two (T num)
 {
     int x = static_cast<int> (num) + 1; 
     if (x == 0) 
-        return static_cast<double> (1);
+        return static_cast<T> (1);
     --x;
     x |= x >> 1;
     x |= x >> 2;
     x |= x >> 4;
     x |= x >> 8;
     x |= x >> 16;
-    return static_cast<double> (x + 1);
+    return static_cast<T> (x + 1);
 }
 
-inline void octree_t::recursive_construction_tree (const point_t& p_min, const point_t& p_max,
-                                                   std::vector<std::size_t>& num_triangles, int depth_recursion)
+template <typename T>
+inline basic_node_t<T>* basic_octree_t<T>::recursive_construction_tree (const point_t& p_min, const point_t& p_max,
+                                                      std::vector<std::size_t>& num_triangles, int depth_recursion)
 {
     depth_recursion++;
     
     if (num_triangles.size () <= OPTIMAL_NUM_TR_IN_SPACE || 
                depth_recursion > MAX_VALUE_DEEP_RECURSION)
     {
-        node_t* main_node = new node_t{num_triangles};
+        node_t* main_node = new node_t{p_min, p_max, num_triangles};
+        array_node_tree_.push_back (main_node);
         array_leaf_tree_.push_back (main_node);
-        return;
+
+        std::size_t depth = depth_recursion - 1;
+        if (depth_histogram_.size () <= depth)
+            depth_histogram_.resize (depth + 1);
+        depth_histogram_[depth]++;
+
+        if (num_triangles.size () > OPTIMAL_NUM_TR_IN_SPACE)
+            num_cut_leaves_++;
+
+        return main_node;
     }
 
+    node_t* main_node = new node_t{p_min, p_max};
+    array_node_tree_.push_back (main_node);
+
     point_t central_point = (p_min + p_max) / 2;
 
     std::array<std::vector<std::size_t>, OCTREE_CHILD_COUNT> array_space{};
@@ -136,12 +414,24 @@ inline void octree_t::recursive_construction_tree (const point_t& p_min, const p
                                           point_t {p_max.x_, p_min.y_, p_min.z_}};
 
 
+    point_t margin (LEAF_MARGIN, LEAF_MARGIN, LEAF_MARGIN);
+    std::array<point_t, OCTREE_CHILD_COUNT> array_min {};
+    std::array<point_t, OCTREE_CHILD_COUNT> array_max {};
+    for (std::size_t i = 0; i < OCTREE_CHILD_COUNT; i++)
+    {
+        const point_t& p = array_point[i];
+        array_min[i] = point_t (std::min (central_point.x_, p.x_), std::min (central_point.y_, p.y_),
+                                std::min (central_point.z_, p.z_)) - margin;
+        array_max[i] = point_t (std::max (central_point.x_, p.x_), std::max (central_point.y_, p.y_),
+                                std::max (central_point.z_, p.z_)) + margin;
+    }
+
     for (auto n_tr = num_triangles.begin(); n_tr != num_triangles.end(); n_tr++)
     {
         triangle_t& tr = array_triangle_[*n_tr];
         for (std::size_t i = 0; i < OCTREE_CHILD_COUNT; i++)
         {
-            if (tr.triangle_lie_in_space (central_point, array_point[i]))
+            if (tr.triangle_lie_in_space (array_min[i], array_max[i]))
             {
                 array_space[i].push_back (*n_tr);
             }
@@ -152,38 +442,835 @@ inline void octree_t::recursive_construction_tree (const point_t& p_min, const p
     {
         if (!array_space[i].empty())
         {
-            recursive_construction_tree (central_point, array_point[i], array_space[i], depth_recursion);
+            main_node->add_child (recursive_construction_tree (central_point, array_point[i],
+                                                               array_space[i], depth_recursion));
         }
     }
+
+    return main_node;
+}
+
+template <typename T>
+template <typename F>
+bool basic_octree_t<T>::for_each_intersecting_pair (F callback) const
+{
+    auto start = std::chrono::steady_clock::now ();
+    bool next = true;
+    for (auto& leaf : array_leaf_tree_)
+    {
+        next = naive_verification (leaf, callback);
+        if (!next)
+            break;
+    }
+
+    verify_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds> (
+                      std::chrono::steady_clock::now () - start).count ();
+    return next;
+}
+
+template <typename T>
+template <typename F>
+bool basic_octree_t<T>::for_each_intersecting_pair (const triangle_t& tr, F callback) const
+{
+    return query_triangle (array_node_tree_.front (), tr, callback);
+}
+
+// Writes at most buffer_size pairs, returns the number of written pairs
+template <typename T>
+inline std::size_t basic_octree_t<T>::get_intersecting_pairs (std::pair<std::size_t, std::size_t>* buffer,
+                                                     std::size_t buffer_size) const
+{
+    std::size_t num_pairs = 0;
+    if (buffer_size == 0)
+        return num_pairs;
+
+    for_each_intersecting_pair ([&] (std::size_t num_1, std::size_t num_2)
+    {
+        buffer[num_pairs++] = { num_1, num_2 };
+        return num_pairs < buffer_size;
+    });
+    return num_pairs;
+}
+
+template <typename T>
+inline bool basic_octree_t<T>::has_intersection () const
+{
+    return !for_each_intersecting_pair ([] (std::size_t, std::size_t) { return false; });
+}
+
+template <typename T>
+inline std::set<std::size_t> basic_octree_t<T>::get_num_tr_intersection () const
+{
+    std::set<std::size_t> num_tr_intersection {};
+    for_each_intersecting_pair ([&] (std::size_t num_1, std::size_t num_2)
+    {
+        num_tr_intersection.insert (num_1);
+        num_tr_intersection.insert (num_2);
+        return true;
+    });
+    return num_tr_intersection;
+}
+
+template <typename T>
+inline std::set<std::size_t> basic_octree_t<T>::get_num_tr_intersection (thread_pool_t& pool) const
+{
+    std::vector<unsigned char> flags = get_intersection_flags (pool);
+
+    // the numbers come in increasing order, every insertion at the end is O(1)
+    std::set<std::size_t> num_tr_intersection {};
+    for (std::size_t num = 0; num < flags.size (); ++num)
+    {
+        if (flags[num])
+            num_tr_intersection.insert (num_tr_intersection.end (), num);
+    }
+    return num_tr_intersection;
+}
+
+template <typename T>
+inline std::vector<unsigned char> basic_octree_t<T>::get_intersection_flags () const
+{
+    std::vector<unsigned char> flags (array_triangle_.size ());
+    for_each_intersecting_pair ([&] (std::size_t num_1, std::size_t num_2)
+    {
+        flags[num_1] = 1;
+        flags[num_2] = 1;
+        return true;
+    });
+    return flags;
+}
+
+// leaves are verified in parallel, each one collects its own hits
+template <typename T>
+inline std::vector<unsigned char> basic_octree_t<T>::get_intersection_flags (thread_pool_t& pool) const
+{
+    auto start = std::chrono::steady_clock::now ();
+    std::vector<std::vector<std::size_t>> num_in_leaf (array_leaf_tree_.size ());
+    pool.parallel_for (0, array_leaf_tree_.size (), [&] (std::size_t i)
+    {
+        auto callback = [&] (std::size_t num_1, std::size_t num_2)
+        {
+            num_in_leaf[i].push_back (num_1);
+            num_in_leaf[i].push_back (num_2);
+            return true;
+        };
+        naive_verification (array_leaf_tree_[i], callback);
+    });
+
+    std::vector<unsigned char> flags (array_triangle_.size ());
+    for (const auto& num : num_in_leaf)
+    {
+        for (auto tmp : num)
+            flags[tmp] = 1;
+    }
+
+    verify_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds> (
+                      std::chrono::steady_clock::now () - start).count ();
+    return flags;
 }
 
-inline std::set<std::size_t> octree_t::get_num_tr_intersection ()
+template <typename T>
+inline std::size_t basic_octree_t<T>::count_candidate_pairs () const
 {
+    std::size_t num_pairs = 0;
     for (auto& leaf : array_leaf_tree_)
     {
-        naive_verification (leaf->get_num_triangles ());
+        std::size_t size = leaf->get_num_triangles ().size ();
+        if (size > 1)
+            num_pairs += size * (size - 1) / 2;
     }
-    return num_tr_intersection_;
+    return num_pairs;
 }
 
-inline void octree_t::naive_verification (std::vector<std::size_t>& num)
+template <typename T>
+inline octree_stats_t basic_octree_t<T>::get_stats () const
 {
-    for (auto it1 = num.begin(); it1 != num.end(); ++it1)
+    octree_stats_t stats {};
+    stats.num_triangles_   = array_triangle_.size ();
+    stats.num_leaves_      = array_leaf_tree_.size ();
+    stats.depth_histogram_ = depth_histogram_;
+    stats.num_cut_leaves_  = num_cut_leaves_;
+
+    std::vector<std::size_t> leaf_sizes {};
+    std::size_t sum_sizes = 0;
+    for (auto& leaf : array_leaf_tree_)
+    {
+        leaf_sizes.push_back (leaf->get_num_triangles ().size ());
+        sum_sizes += leaf_sizes.back ();
+    }
+
+    if (!leaf_sizes.empty ())
+    {
+        std::sort (leaf_sizes.begin (), leaf_sizes.end ());
+        std::size_t num_p99 = (leaf_sizes.size () * 99 + 99) / 100;
+
+        stats.min_tr_in_leaf_ = leaf_sizes.front ();
+        stats.max_tr_in_leaf_ = leaf_sizes.back ();
+        stats.p99_tr_in_leaf_ = leaf_sizes[num_p99 - 1];
+        stats.avg_tr_in_leaf_ = static_cast<double> (sum_sizes) / leaf_sizes.size ();
+    }
+
+    if (!array_triangle_.empty ())
+        stats.duplication_factor_ = static_cast<double> (sum_sizes) / array_triangle_.size ();
+
+    stats.num_pair_tests_   = num_pair_tests_;
+    stats.num_hits_         = num_hits_;
+    stats.bounding_cube_ms_ = bounding_cube_ms_;
+    stats.build_ms_         = build_ms_;
+    stats.verify_ms_        = verify_ns_ / 1e6;
+    return stats;
+}
+
+template <typename T>
+template <typename F>
+bool basic_octree_t<T>::naive_verification (const node_t* leaf, F& callback) const
+{
+    if (gather_leaves_ && leaf->get_num_triangles ().size () <= LEAF_BUFFER_CAPACITY && !leaf_buffer ().in_use_)
+        return gathered_verification (leaf, callback);
+
+    std::size_t num_pair_tests = 0;
+    std::size_t num_hits = 0;
+    bool next = true;
+
+    const std::vector<std::size_t>& num = leaf->get_num_triangles ();
+    for (auto it1 = num.begin(); it1 != num.end() && next; ++it1)
     {
         auto it2 = it1;
         ++it2;
 
+        const triangle_t& tr1 = array_triangle_[*it1];
         for (; it2 != num.end(); ++it2)
         {
-            if (array_triangle_[*it1].check_intersection(array_triangle_[*it2]))
+            const triangle_t& tr2 = array_triangle_[*it2];
+            if (!leaf_owns_pair (leaf, tr1, tr2))
+                continue;
+
+            num_pair_tests++;
+            if (tr1.check_intersection (tr2, kernel_))
+            {
+                num_hits++;
+                next = callback (*it1, *it2);
+                if (!next)
+                    break;
+            }
+        }
+    }
+
+    num_pair_tests_.fetch_add (num_pair_tests, std::memory_order_relaxed);
+    num_hits_.fetch_add (num_hits, std::memory_order_relaxed);
+    return next;
+}
+
+template <typename T>
+inline basic_leaf_buffer_t<T>& basic_octree_t<T>::leaf_buffer ()
+{
+    thread_local basic_leaf_buffer_t<T> buffer {};
+    return buffer;
+}
+
+// A pair whose boxes are farther apart than kernel_margin, which the kernel would
+// reject by boxes_near, is skipped on the copied boxes before the triangles are
+// touched. The ownership is decided by the boxes themselves, as in leaf_owns_pair.
+template <typename T>
+template <typename F>
+bool basic_octree_t<T>::gathered_verification (const node_t* leaf, F& callback) const
+{
+    basic_leaf_buffer_t<T>& buffer = leaf_buffer ();
+    buffer.in_use_ = true;
+
+    const std::vector<std::size_t>& num = leaf->get_num_triangles ();
+    buffer.size_ = num.size ();
+    for (std::size_t i = 0; i < buffer.size_; ++i)
+    {
+        const triangle_t& tr = array_triangle_[num[i]];
+        buffer.triangles_[i] = tr;
+        buffer.min_x_[i] = tr.get_p_min ().x_;
+        buffer.min_y_[i] = tr.get_p_min ().y_;
+        buffer.min_z_[i] = tr.get_p_min ().z_;
+        buffer.max_x_[i] = tr.get_p_max ().x_;
+        buffer.max_y_[i] = tr.get_p_max ().y_;
+        buffer.max_z_[i] = tr.get_p_max ().z_;
+    }
+
+    T margin = kernel_margin<T> (kernel_);
+    std::size_t num_pair_tests = 0;
+    std::size_t num_hits = 0;
+    bool next = true;
+
+    for (std::size_t i = 0; i < buffer.size_ && next; ++i)
+    {
+        point_t p_min_1 (buffer.min_x_[i], buffer.min_y_[i], buffer.min_z_[i]);
+        point_t p_max_1 (buffer.max_x_[i], buffer.max_y_[i], buffer.max_z_[i]);
+        for (std::size_t j = i + 1; j < buffer.size_; ++j)
+        {
+            if (p_max_1.x_ + margin < buffer.min_x_[j] || buffer.max_x_[j] + margin < p_min_1.x_ ||
+                p_max_1.y_ + margin < buffer.min_y_[j] || buffer.max_y_[j] + margin < p_min_1.y_ ||
+                p_max_1.z_ + margin < buffer.min_z_[j] || buffer.max_z_[j] + margin < p_min_1.z_)
+                continue;
+
+            point_t p_min_2 (buffer.min_x_[j], buffer.min_y_[j], buffer.min_z_[j]);
+            point_t p_max_2 (buffer.max_x_[j], buffer.max_y_[j], buffer.max_z_[j]);
+            if (!leaf_owns_pair (leaf, p_min_1, p_max_1, p_min_2, p_max_2))
+                continue;
+
+            num_pair_tests++;
+            if (buffer.triangles_[i].check_intersection (buffer.triangles_[j], kernel_))
+            {
+                num_hits++;
+                next = callback (num[i], num[j]);
+                if (!next)
+                    break;
+            }
+        }
+    }
+    buffer.in_use_ = false;
+
+    num_pair_tests_.fetch_add (num_pair_tests, std::memory_order_relaxed);
+    num_hits_.fetch_add (num_hits, std::memory_order_relaxed);
+    return next;
+}
+
+template <typename T>
+inline std::set<std::size_t> basic_octree_t<T>::get_num_tr_intersection (const triangle_t& tr) const
+{
+    std::set<std::size_t> num_tr {};
+    for_each_intersecting_pair (tr, [&] (std::size_t num)
+    {
+        num_tr.insert (num);
+        return true;
+    });
+    return num_tr;
+}
+
+template <typename T>
+template <typename F>
+bool basic_octree_t<T>::query_triangle (const node_t* node, const triangle_t& tr, F& callback) const
+{
+    point_t margin (LEAF_MARGIN, LEAF_MARGIN, LEAF_MARGIN);
+    if (!tr.triangle_lie_in_space (node->get_p_min () - margin, node->get_p_max () + margin))
+        return true;
+
+    if (!node->is_leaf ())
+    {
+        for (auto child : node->get_children ())
+        {
+            if (!query_triangle (child, tr, callback))
+                return false;
+        }
+        return true;
+    }
+
+    std::size_t num_pair_tests = 0;
+    std::size_t num_hits = 0;
+    bool next = true;
+
+    for (auto n_tr : node->get_num_triangles ())
+    {
+        const triangle_t& other = array_triangle_[n_tr];
+        if (!leaf_owns_pair (node, tr, other))
+            continue;
+
+        num_pair_tests++;
+        if (other.check_intersection (tr, kernel_))
+        {
+            num_hits++;
+            next = callback (n_tr);
+            if (!next)
+                break;
+        }
+    }
+
+    num_pair_tests_.fetch_add (num_pair_tests, std::memory_order_relaxed);
+    num_hits_.fetch_add (num_hits, std::memory_order_relaxed);
+    return next;
+}
+
+// A triangle is copied into every leaf its bounding box, widened by LEAF_MARGIN, touches,
+// so a pair of triangles can meet in several leaves. The pair is checked only in the leaf
+// that contains the minimum corner of the overlap of their widened boxes (leaves are
+// half-open cubes).
+template <typename T>
+inline bool basic_octree_t<T>::leaf_owns_pair (const node_t* leaf, const triangle_t& tr1, const triangle_t& tr2) const
+{
+    return leaf_owns_pair (leaf, tr1.get_p_min (), tr1.get_p_max (), tr2.get_p_min (), tr2.get_p_max ());
+}
+
+template <typename T>
+inline bool basic_octree_t<T>::leaf_owns_pair (const node_t* leaf, const point_t& p_min_1, const point_t& p_max_1,
+                                      const point_t& p_min_2, const point_t& p_max_2) const
+{
+    point_t margin (LEAF_MARGIN, LEAF_MARGIN, LEAF_MARGIN);
+    return leaf_owns_overlap (leaf, p_min_1 - margin, p_max_1 + margin, p_min_2 - margin, p_max_2 + margin);
+}
+
+template <typename T>
+inline bool basic_octree_t<T>::leaf_owns_overlap (const node_t* leaf, const point_t& p_min_1, const point_t& p_max_1,
+                                         const point_t& p_min_2, const point_t& p_max_2) const
+{
+    point_t p { std::min (std::max (p_min_1.x_, p_min_2.x_), std::min (p_max_1.x_, p_max_2.x_)),
+                std::min (std::max (p_min_1.y_, p_min_2.y_), std::min (p_max_1.y_, p_max_2.y_)),
+                std::min (std::max (p_min_1.z_, p_min_2.z_), std::min (p_max_1.z_, p_max_2.z_)) };
+
+    // the widened boxes of triangles at the border may stick out of the root
+    point_t root_min = array_node_tree_.front ()->get_p_min ();
+    point_t root_max = array_node_tree_.front ()->get_p_max ();
+    p = point_t (std::min (std::max (p.x_, root_min.x_), root_max.x_),
+                 std::min (std::max (p.y_, root_min.y_), root_max.y_),
+                 std::min (std::max (p.z_, root_min.z_), root_max.z_));
+
+    point_t leaf_min = leaf->get_p_min ();
+    point_t leaf_max = leaf->get_p_max ();
+
+    auto lie_in_axis = [] (T c, T min, T max, T root_max)
+    {
+        return (c >= min && (c < max || (max == root_max && c <= max)));
+    };
+
+    return (lie_in_axis (p.x_, leaf_min.x_, leaf_max.x_, root_max.x_) &&
+            lie_in_axis (p.y_, leaf_min.y_, leaf_max.y_, root_max.y_) &&
+            lie_in_axis (p.z_, leaf_min.z_, leaf_max.z_, root_max.z_));
+}
+
+template <typename T>
+template <typename F>
+bool basic_octree_t<T>::for_each_triangle_in_box (const point_t& p1, const point_t& p2, F callback) const
+{
+    point_t p_min (std::min (p1.x_, p2.x_), std::min (p1.y_, p2.y_), std::min (p1.z_, p2.z_));
+    point_t p_max (std::max (p1.x_, p2.x_), std::max (p1.y_, p2.y_), std::max (p1.z_, p2.z_));
+    auto predicate = [] (const triangle_t&) { return true; };
+    return range_traversal (array_node_tree_.front (), p_min, p_max, predicate, callback);
+}
+
+template <typename T>
+template <typename F>
+bool basic_octree_t<T>::for_each_triangle_in_sphere (const point_t& center, T radius, F callback) const
+{
+    point_t p_radius (radius, radius, radius);
+    auto predicate = [&] (const triangle_t& tr)
+    {
+        vector_t vec { center, tr.closest_point (center) };
+        return (vec.scalar_product (vec) <= radius * radius);
+    };
+    return range_traversal (array_node_tree_.front (), center - p_radius, center + p_radius,
+                            predicate, callback);
+}
+
+template <typename T>
+inline std::vector<std::size_t> basic_octree_t<T>::get_num_tr_in_box (const point_t& p1, const point_t& p2) const
+{
+    std::vector<std::size_t> num_tr {};
+    for_each_triangle_in_box (p1, p2, [&] (std::size_t num)
+    {
+        num_tr.push_back (num);
+        return true;
+    });
+    std::sort (num_tr.begin (), num_tr.end ());
+    return num_tr;
+}
+
+template <typename T>
+inline std::vector<std::size_t> basic_octree_t<T>::get_num_tr_in_sphere (const point_t& center, T radius) const
+{
+    std::vector<std::size_t> num_tr {};
+    for_each_triangle_in_sphere (center, radius, [&] (std::size_t num)
+    {
+        num_tr.push_back (num);
+        return true;
+    });
+    std::sort (num_tr.begin (), num_tr.end ());
+    return num_tr;
+}
+
+template <typename T>
+inline std::vector<std::vector<std::size_t>> basic_octree_t<T>::get_num_tr_in_box (
+    const std::vector<std::pair<point_t, point_t>>& boxes, thread_pool_t& pool) const
+{
+    std::vector<std::vector<std::size_t>> num_tr (boxes.size ());
+    pool.parallel_for (0, boxes.size (), [&] (std::size_t i)
+    {
+        num_tr[i] = get_num_tr_in_box (boxes[i].first, boxes[i].second);
+    });
+    return num_tr;
+}
+
+template <typename T>
+inline std::vector<std::vector<std::size_t>> basic_octree_t<T>::get_num_tr_in_sphere (
+    const std::vector<std::pair<point_t, T>>& spheres, thread_pool_t& pool) const
+{
+    std::vector<std::vector<std::size_t>> num_tr (spheres.size ());
+    pool.parallel_for (0, spheres.size (), [&] (std::size_t i)
+    {
+        num_tr[i] = get_num_tr_in_sphere (spheres[i].first, spheres[i].second);
+    });
+    return num_tr;
+}
+
+// p_min, p_max bound the query region, predicate is the exact test of a triangle
+// whose bounding box overlaps the region
+template <typename T>
+template <typename P, typename F>
+bool basic_octree_t<T>::range_traversal (const node_t* node, const point_t& p_min, const point_t& p_max,
+                                P& predicate, F& callback) const
+{
+    point_t node_min = node->get_p_min ();
+    point_t node_max = node->get_p_max ();
+    if (p_max.x_ < node_min.x_ || p_min.x_ > node_max.x_ ||
+        p_max.y_ < node_min.y_ || p_min.y_ > node_max.y_ ||
+        p_max.z_ < node_min.z_ || p_min.z_ > node_max.z_)
+    {
+        return true;
+    }
+
+    if (!node->is_leaf ())
+    {
+        for (auto child : node->get_children ())
+        {
+            if (!range_traversal (child, p_min, p_max, predicate, callback))
+                return false;
+        }
+        return true;
+    }
+
+    for (auto n_tr : node->get_num_triangles ())
+    {
+        const triangle_t& tr = array_triangle_[n_tr];
+        if (tr.triangle_lie_in_space (p_min, p_max) &&
+            leaf_owns_overlap (node, p_min, p_max, tr.get_p_min (), tr.get_p_max ()) &&
+            predicate (tr))
+        {
+            if (!callback (n_tr))
+                return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+inline T basic_octree_t<T>::get_min_distance (const triangle_t& tr, std::size_t& num_tr,
+                                         T max_distance) const
+{
+    T min_distance = max_distance;
+    std::size_t num_nearest = array_triangle_.size ();
+    nearest_traversal (array_node_tree_.front (), tr, num_nearest, min_distance);
+
+    if (num_nearest == array_triangle_.size ())
+        return INFINITY;
+
+    num_tr = num_nearest;
+    return min_distance;
+}
+
+// The point of a triangle nearest to tr lies in a leaf holding that triangle, so the
+// distance from tr to a cell bounds the distance to every triangle found through it.
+template <typename T>
+inline void basic_octree_t<T>::nearest_traversal (const node_t* node, const triangle_t& tr, std::size_t& num_tr,
+                                         T& min_distance) const
+{
+    if (node->is_leaf ())
+    {
+        for (auto n_tr : node->get_num_triangles ())
+        {
+            const triangle_t& other = array_triangle_[n_tr];
+            if (distance_box_box (tr.get_p_min (), tr.get_p_max (),
+                                  other.get_p_min (), other.get_p_max ()) >= min_distance)
+            {
+                continue;
+            }
+
+            T distance = tr.distance (other);
+            if (distance < min_distance)
+            {
+                min_distance = distance;
+                num_tr = n_tr;
+            }
+        }
+        return;
+    }
+
+    std::array<std::pair<T, const node_t*>, OCTREE_CHILD_COUNT> array_child {};
+    std::size_t num_child = 0;
+    for (auto child : node->get_children ())
+    {
+        array_child[num_child++] = { distance_box_box (tr.get_p_min (), tr.get_p_max (),
+                                                       child->get_p_min (), child->get_p_max ()), child };
+    }
+
+    sort_children (array_child, num_child);
+
+    for (std::size_t i = 0; i < num_child; ++i)
+    {
+        if (array_child[i].first >= min_distance)
+            return;
+        nearest_traversal (array_child[i].second, tr, num_tr, min_distance);
+    }
+}
+
+template <typename T>
+template <typename F>
+bool basic_octree_t<T>::for_each_triangle_within_distance (const triangle_t& tr, T distance, F callback) const
+{
+    point_t p_distance (distance, distance, distance);
+    T tr_distance = 0;
+
+    auto predicate = [&] (const triangle_t& other)
+    {
+        tr_distance = tr.distance (other);
+        return (tr_distance <= distance);
+    };
+    auto callback_distance = [&] (std::size_t num) { return callback (num, tr_distance); };
+
+    return range_traversal (array_node_tree_.front (), tr.get_p_min () - p_distance,
+                            tr.get_p_max () + p_distance, predicate, callback_distance);
+}
+
+template <typename T>
+inline T basic_octree_t<T>::distance_box_box (const point_t& p_min_1, const point_t& p_max_1,
+                                          const point_t& p_min_2, const point_t& p_max_2)
+{
+    T dx = std::max (T (0), std::max (p_min_1.x_ - p_max_2.x_, p_min_2.x_ - p_max_1.x_));
+    T dy = std::max (T (0), std::max (p_min_1.y_ - p_max_2.y_, p_min_2.y_ - p_max_1.y_));
+    T dz = std::max (T (0), std::max (p_min_1.z_ - p_max_2.z_, p_min_2.z_ - p_max_1.z_));
+    return std::sqrt (dx * dx + dy * dy + dz * dz);
+}
+
+template <typename T>
+inline basic_ray_hit_t<T> basic_octree_t<T>::get_first_hit (const ray_t& ray) const
+{
+    ray_hit_t hit {};
+    ray_traversal<false> (array_node_tree_.front (), ray, hit);
+    return hit;
+}
+
+template <typename T>
+inline basic_ray_hit_t<T> basic_octree_t<T>::get_any_hit (const ray_t& ray) const
+{
+    ray_hit_t hit {};
+    ray_traversal<true> (array_node_tree_.front (), ray, hit);
+    return hit;
+}
+
+template <typename T>
+inline std::vector<basic_ray_hit_t<T>> basic_octree_t<T>::get_first_hit (const std::vector<ray_t>& rays,
+                                                       thread_pool_t& pool) const
+{
+    std::vector<ray_hit_t> hits (rays.size ());
+    pool.parallel_for (0, rays.size (), [&] (std::size_t i) { hits[i] = get_first_hit (rays[i]); });
+    return hits;
+}
+
+template <typename T>
+inline std::vector<basic_ray_hit_t<T>> basic_octree_t<T>::get_any_hit (const std::vector<ray_t>& rays,
+                                                     thread_pool_t& pool) const
+{
+    std::vector<ray_hit_t> hits (rays.size ());
+    pool.parallel_for (0, rays.size (), [&] (std::size_t i) { hits[i] = get_any_hit (rays[i]); });
+    return hits;
+}
+
+// Children are visited front to back and skipped as soon as the ray enters them
+// further than the nearest hit found so far. A triangle sticks out of its leaf,
+// so a hit in a near leaf can still be beaten by a hit found in a farther one.
+template <typename T>
+template <bool any_hit>
+void basic_octree_t<T>::ray_traversal (const node_t* node, const ray_t& ray, ray_hit_t& hit) const
+{
+    if (node->is_leaf ())
+    {
+        for (auto n_tr : node->get_num_triangles ())
+        {
+            T t = 0;
+            if (array_triangle_[n_tr].check_intersection_ray (ray, t) && t < hit.t_)
             {
-                num_tr_intersection_.insert (*it1);
-                num_tr_intersection_.insert (*it2);
+                hit = { true, n_tr, t };
+                if (any_hit)
+                    return;
             }
         }
+        return;
+    }
+
+    std::array<std::pair<T, const node_t*>, OCTREE_CHILD_COUNT> array_child {};
+    std::size_t num_child = 0;
+    for (auto child : node->get_children ())
+    {
+        T t_enter = 0;
+        if (ray_cross_cube (ray, child->get_p_min (), child->get_p_max (), t_enter))
+        {
+            array_child[num_child++] = { t_enter, child };
+        }
+    }
+
+    sort_children (array_child, num_child);
+
+    for (std::size_t i = 0; i < num_child; ++i)
+    {
+        if (array_child[i].first > hit.t_ || (any_hit && hit.hit_))
+            return;
+        ray_traversal<any_hit> (array_child[i].second, ray, hit);
+    }
+}
+
+// slab test, t_enter is the ray parameter where the ray enters the cube
+template <typename T>
+inline bool basic_octree_t<T>::ray_cross_cube (const ray_t& ray, const point_t& p_min, const point_t& p_max,
+                                      T& t_enter)
+{
+    T t_min = 0;
+    T t_max = ray.t_max_;
+
+    const T origin[]    = { ray.origin_.x_, ray.origin_.y_, ray.origin_.z_ };
+    const T direction[] = { ray.direction_.get_x (), ray.direction_.get_y (), ray.direction_.get_z () };
+    const T cube_min[]  = { p_min.x_, p_min.y_, p_min.z_ };
+    const T cube_max[]  = { p_max.x_, p_max.y_, p_max.z_ };
+
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        if (direction[i] == 0)
+        {
+            if (origin[i] < cube_min[i] || origin[i] > cube_max[i])
+                return false;
+            continue;
+        }
+
+        T t1 = (cube_min[i] - origin[i]) / direction[i];
+        T t2 = (cube_max[i] - origin[i]) / direction[i];
+        t_min = std::max (t_min, std::min (t1, t2));
+        t_max = std::min (t_max, std::max (t1, t2));
+
+        if (t_min > t_max)
+            return false;
     }
+
+    t_enter = t_min;
+    return true;
 }
 
 // ----------------------------------------------------------------------------------
 
+// ------------------------------OTHER_FUNC------------------------------------------
+
+// Intersection of two meshes: the tree is built over the larger one and the smaller one
+// is streamed through it, so only pairs from different meshes are checked.
+// callback (num_a, num_b) gets the number of the triangle in array_a and in array_b,
+// returning false stops the search.
+template <typename T, typename F>
+bool for_each_intersecting_pair (std::vector<basic_triangle_t<T>>& array_a,
+                                 std::vector<basic_triangle_t<T>>& array_b, F callback)
+{
+    bool a_is_larger = (array_a.size () >= array_b.size ());
+    std::vector<basic_triangle_t<T>>& array_large = a_is_larger ? array_a : array_b;
+    std::vector<basic_triangle_t<T>>& array_small = a_is_larger ? array_b : array_a;
+
+    if (array_large.empty ())
+        return true;
+
+    basic_octree_t<T> tree (array_large);
+    for (std::size_t i = 0; i < array_small.size (); ++i)
+    {
+        bool next = tree.for_each_intersecting_pair (array_small[i], [&] (std::size_t num)
+        {
+            return a_is_larger ? callback (num, i) : callback (i, num);
+        });
+
+        if (!next)
+            return false;
+    }
+    return true;
+}
+
+// Returns the numbers of intersecting triangles of array_a and of array_b
+template <typename T>
+std::pair<std::set<std::size_t>, std::set<std::size_t>>
+get_num_tr_intersection (std::vector<basic_triangle_t<T>>& array_a, std::vector<basic_triangle_t<T>>& array_b)
+{
+    std::set<std::size_t> num_a {};
+    std::set<std::size_t> num_b {};
+
+    for_each_intersecting_pair (array_a, array_b, [&] (std::size_t i, std::size_t j)
+    {
+        num_a.insert (i);
+        num_b.insert (j);
+        return true;
+    });
+
+    return { num_a, num_b };
+}
+
+template <typename T>
+struct basic_distance_t
+{
+    T distance_ = INFINITY;
+    std::size_t num_a_ = 0;
+    std::size_t num_b_ = 0;
+};
+
+// Minimum distance between two meshes, 0 if they intersect.
+// The tree is built over the larger mesh and its bound shrinks as the search goes.
+template <typename T>
+basic_distance_t<T> get_min_distance (std::vector<basic_triangle_t<T>>& array_a,
+                                      std::vector<basic_triangle_t<T>>& array_b)
+{
+    bool a_is_larger = (array_a.size () >= array_b.size ());
+    std::vector<basic_triangle_t<T>>& array_large = a_is_larger ? array_a : array_b;
+    std::vector<basic_triangle_t<T>>& array_small = a_is_larger ? array_b : array_a;
+
+    basic_distance_t<T> min_distance {};
+    if (array_large.empty ())
+        return min_distance;
+
+    basic_octree_t<T> tree (array_large);
+    for (std::size_t i = 0; i < array_small.size () && min_distance.distance_ > 0; ++i)
+    {
+        std::size_t num = 0;
+        T distance = tree.get_min_distance (array_small[i], num, min_distance.distance_);
+        if (distance < min_distance.distance_)
+        {
+            min_distance = a_is_larger ? basic_distance_t<T> { distance, num, i } :
+                                         basic_distance_t<T> { distance, i, num };
+        }
+    }
+    return min_distance;
+}
+
+// callback (num_a, num_b, distance) for every pair of triangles not farther than distance
+template <typename T, typename F>
+bool for_each_pair_within_distance (std::vector<basic_triangle_t<T>>& array_a,
+                                    std::vector<basic_triangle_t<T>>& array_b, T distance, F callback)
+{
+    bool a_is_larger = (array_a.size () >= array_b.size ());
+    std::vector<basic_triangle_t<T>>& array_large = a_is_larger ? array_a : array_b;
+    std::vector<basic_triangle_t<T>>& array_small = a_is_larger ? array_b : array_a;
+
+    if (array_large.empty ())
+        return true;
+
+    basic_octree_t<T> tree (array_large);
+    for (std::size_t i = 0; i < array_small.size (); ++i)
+    {
+        bool next = tree.for_each_triangle_within_distance (array_small[i], distance,
+            [&] (std::size_t num, T tr_distance)
+            {
+                return a_is_larger ? callback (num, i, tr_distance) : callback (i, num, tr_distance);
+            });
+
+        if (!next)
+            return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------SCALAR_TYPES----------------------------------------
+
+using node_t     = basic_node_t<double>;
+using ray_hit_t  = basic_ray_hit_t<double>;
+using octree_t   = basic_octree_t<double>;
+using distance_t = basic_distance_t<double>;
+
+extern template class basic_octree_t<float>;
+extern template class basic_octree_t<double>;
+extern template class basic_octree_t<long double>;
+
+// ----------------------------------------------------------------------------------
+
 #endif // OCTREE_HPP
\ No newline at end of file
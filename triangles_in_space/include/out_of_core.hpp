@@ -0,0 +1,401 @@
+#ifndef OUT_OF_CORE_HPP
+#define OUT_OF_CORE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+#include "triangles.hpp"
+#include "octree.hpp"
+#include "output.hpp"
+#include "partition.hpp"
+
+const std::size_t OUT_OF_CORE_DEFAULT_BUDGET_MB = 1024;
+// a bucket is split into at most OUT_OF_CORE_MAX_FANOUT buckets, at most as many
+// result files are merged at once
+const std::size_t OUT_OF_CORE_MAX_FANOUT = 256;
+// a bucket still over the budget after OUT_OF_CORE_MAX_DEPTH splits is verified anyway
+const std::size_t OUT_OF_CORE_MAX_DEPTH = 4;
+// buckets are cut for OUT_OF_CORE_FILL of the capacity, the rest is left for the
+// copies of the triangles crossing the boundaries and for the error of the sample
+const double OUT_OF_CORE_FILL = 0.75;
+// smaller budgets are raised to OUT_OF_CORE_MIN_CAPACITY triangles in a bucket
+const std::size_t OUT_OF_CORE_MIN_CAPACITY = 1024;
+const std::size_t OUT_OF_CORE_MIN_FILE_BUFFER = 1 << 12;
+const std::size_t OUT_OF_CORE_MAX_FILE_BUFFER = 1 << 16;
+const std::size_t OUT_OF_CORE_READ_RECORDS = 4096;
+
+// ------------------------------OUT_OF_CORE_STATS_T---------------------------------
+
+struct out_of_core_stats_t
+{
+    std::size_t num_triangles_ = 0;
+    std::size_t bucket_capacity_ = 0;
+    std::size_t num_buckets_ = 0; // verified in memory
+    std::size_t num_splits_ = 0;
+    std::size_t num_bucket_triangles_ = 0; // in all the buckets, with the copies
+    std::size_t max_bucket_triangles_ = 0;
+    std::size_t num_over_budget_ = 0; // buckets that could not be split under the capacity
+};
+
+// defined in src/out_of_core.cpp
+std::ostream& operator<< (std::ostream& out, const out_of_core_stats_t& stats);
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------FILES-----------------------------------------------
+
+// a file with its own buffer of buffer_size bytes; defined in src/out_of_core.cpp
+class buffered_file_t
+{
+private:
+    std::vector<char> buffer_;
+    std::FILE* file_ = nullptr;
+
+public:
+    buffered_file_t (const std::string& path, const char* mode, std::size_t buffer_size);
+    ~buffered_file_t () { close (); }
+
+    buffered_file_t (const buffered_file_t&) = delete;
+    buffered_file_t& operator= (const buffered_file_t&) = delete;
+
+    bool is_open () const { return file_ != nullptr; }
+    std::FILE* get () const { return file_; }
+    // false if the file was not open or a write failed
+    bool close ();
+};
+
+// a new name in directory for a temporary file of this process
+std::string temporary_file_path (const std::string& directory);
+
+// Merges the sorted files of std::uint64_t numbers and calls callback (num) once for
+// every distinct number in increasing order; the files are removed. At most
+// OUT_OF_CORE_MAX_FANOUT files are open at once, more files are merged in rounds
+// through temporary files in directory. False on an error of a file or if callback
+// returns false.
+bool merge_number_files (std::vector<std::string> paths, const std::string& directory, std::size_t buffer_size,
+                         const std::function<bool (std::uint64_t)>& callback);
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------OUT_OF_CORE_T---------------------------------------
+
+// a triangle in the files of the buckets: its number in the input and its coordinates
+template <typename T>
+struct basic_record_t
+{
+    std::uint64_t num_;
+    T coords_[9];
+};
+
+// memory of a triangle of a bucket verified in memory: the record, the triangle and
+// the leaves of the tree with the copies of the triangle
+template <typename T>
+std::size_t out_of_core_bytes_per_triangle ()
+{
+    return sizeof (basic_record_t<T>) + sizeof (basic_triangle_t<T>) + 64;
+}
+
+// Verification of scenes larger than the memory. The input is copied into a file of
+// records, which is a bucket; a bucket of more triangles than fit into the memory
+// budget is cut into slabs of partition.hpp, each one written into its own file, and
+// so on. A bucket that fits is read back and verified by an octree on the pool; its
+// intersecting triangles, sorted by number, go to a result file. The result files are
+// merged into the output at the end, so the memory holds at most one bucket, the
+// buffers of the open files and never anything of the size of the whole scene. A
+// triangle crossing a boundary is copied into both buckets and may be found in both,
+// the merge reports it once.
+template <typename T>
+class basic_out_of_core_t
+{
+public:
+    using record_t   = basic_record_t<T>;
+    using triangle_t = basic_triangle_t<T>;
+
+private:
+    std::string directory_;
+    std::size_t capacity_;
+    std::size_t file_buffer_size_;
+    thread_pool_t& pool_;
+    kernel_t kernel_;
+    std::vector<std::string> result_paths_ {};
+    out_of_core_stats_t stats_ {};
+
+    bool spill (std::istream& in, const std::string& path, std::size_t& num_triangles);
+    bool process_bucket (const std::string& path, std::size_t num_triangles, std::size_t depth);
+    bool split_bucket (const std::string& path, std::size_t num_triangles,
+                       std::vector<std::pair<std::string, std::size_t>>& buckets);
+    bool verify_bucket (const std::string& path, std::size_t num_triangles);
+    static bool read_records (std::FILE* file, std::vector<record_t>& records);
+
+public:
+    // memory_budget in bytes, the temporary files are created in directory
+    basic_out_of_core_t (const std::string& directory, std::size_t memory_budget, thread_pool_t& pool,
+                         kernel_t kernel = DEFAULT_KERNEL);
+    ~basic_out_of_core_t ();
+
+    basic_out_of_core_t (const basic_out_of_core_t&) = delete;
+    basic_out_of_core_t& operator= (const basic_out_of_core_t&) = delete;
+
+    // Reads the input of the main program from in and writes the numbers of the
+    // intersecting triangles to file in format. False on an error of a file or on an
+    // input that is truncated or not a number, in is failed then.
+    bool run (std::istream& in, std::FILE* file, output_format_t format);
+
+    std::size_t get_bucket_capacity () const { return capacity_; }
+    const out_of_core_stats_t& get_stats () const { return stats_; }
+};
+
+template <typename T>
+inline basic_out_of_core_t<T>::basic_out_of_core_t (const std::string& directory, std::size_t memory_budget,
+                                                     thread_pool_t& pool, kernel_t kernel) :
+    directory_(directory),
+    capacity_(std::max (memory_budget / out_of_core_bytes_per_triangle<T> (), OUT_OF_CORE_MIN_CAPACITY)),
+    file_buffer_size_(std::clamp (memory_budget / (4 * OUT_OF_CORE_MAX_FANOUT),
+                                  OUT_OF_CORE_MIN_FILE_BUFFER, OUT_OF_CORE_MAX_FILE_BUFFER)),
+    pool_(pool),
+    kernel_(kernel)
+{
+    stats_.bucket_capacity_ = capacity_;
+}
+
+template <typename T>
+inline basic_out_of_core_t<T>::~basic_out_of_core_t ()
+{
+    for (const auto& path : result_paths_)
+        std::remove (path.c_str ());
+}
+
+template <typename T>
+bool basic_out_of_core_t<T>::run (std::istream& in, std::FILE* file, output_format_t format)
+{
+    std::string input = temporary_file_path (directory_);
+    std::size_t num_triangles = 0;
+    if (!spill (in, input, num_triangles))
+    {
+        std::remove (input.c_str ());
+        return false;
+    }
+
+    stats_.num_triangles_ = num_triangles;
+    if (!process_bucket (input, num_triangles, 0))
+        return false;
+
+    number_writer_t writer (file, format, num_triangles);
+    std::vector<std::string> paths {};
+    paths.swap (result_paths_);
+    bool merged = merge_number_files (std::move (paths), directory_, file_buffer_size_,
+                                      [&] (std::uint64_t num) { return writer.add (num); });
+    return merged && writer.finish ();
+}
+
+// the triangles of in as records numbered in the order of the input; false if in ends
+// before the last coordinate or holds something else than a number
+template <typename T>
+bool basic_out_of_core_t<T>::spill (std::istream& in, const std::string& path, std::size_t& num_triangles)
+{
+    num_triangles = 0;
+    if (!(in >> num_triangles))
+        return false;
+
+    buffered_file_t file (path, "wb", file_buffer_size_);
+    if (!file.is_open ())
+        return false;
+
+    record_t record {};
+    for (std::size_t num = 0; num < num_triangles; ++num)
+    {
+        record.num_ = num;
+        for (auto& tmp : record.coords_)
+        {
+            in >> tmp;
+        }
+        if (!in || std::fwrite (&record, sizeof (record), 1, file.get ()) != 1)
+            return false;
+    }
+    return file.close ();
+}
+
+template <typename T>
+bool basic_out_of_core_t<T>::process_bucket (const std::string& path, std::size_t num_triangles, std::size_t depth)
+{
+    if (num_triangles <= capacity_ || depth >= OUT_OF_CORE_MAX_DEPTH)
+    {
+        if (num_triangles > capacity_)
+            stats_.num_over_budget_++;
+        return verify_bucket (path, num_triangles);
+    }
+
+    std::vector<std::pair<std::string, std::size_t>> buckets {};
+    if (!split_bucket (path, num_triangles, buckets))
+    {
+        std::remove (path.c_str ());
+        return false;
+    }
+
+    // every triangle crosses the boundaries, the bucket cannot be split
+    if (std::any_of (buckets.begin (), buckets.end (), [&] (const auto& bucket) { return bucket.second == num_triangles; }))
+    {
+        for (const auto& bucket : buckets)
+            std::remove (bucket.first.c_str ());
+        return process_bucket (path, num_triangles, OUT_OF_CORE_MAX_DEPTH);
+    }
+
+    std::remove (path.c_str ());
+    stats_.num_splits_++;
+    for (std::size_t i = 0; i < buckets.size (); ++i)
+    {
+        if (!process_bucket (buckets[i].first, buckets[i].second, depth + 1))
+        {
+            for (std::size_t rest = i + 1; rest < buckets.size (); ++rest)
+                std::remove (buckets[rest].first.c_str ());
+            return false;
+        }
+    }
+    return true;
+}
+
+// the records of the bucket path cut into slabs, every slab into its own file
+template <typename T>
+bool basic_out_of_core_t<T>::split_bucket (const std::string& path, std::size_t num_triangles,
+                                           std::vector<std::pair<std::string, std::size_t>>& buckets)
+{
+    std::size_t num_buckets = static_cast<std::size_t> (std::ceil (num_triangles / (capacity_ * OUT_OF_CORE_FILL)));
+    num_buckets = std::clamp<std::size_t> (num_buckets, 2, OUT_OF_CORE_MAX_FANOUT);
+
+    buffered_file_t in (path, "rb", file_buffer_size_);
+    if (!in.is_open ())
+        return false;
+
+    std::vector<std::vector<T>> centers {};
+    std::size_t step = std::max<std::size_t> (num_triangles / PARTITION_SAMPLE_SIZE, 1);
+    record_t record {};
+    for (std::size_t num = 0; num < num_triangles; num += step)
+    {
+        if (std::fseek (in.get (), static_cast<long> (num * sizeof (record)), SEEK_SET) != 0 ||
+            std::fread (&record, sizeof (record), 1, in.get ()) != 1)
+            return false;
+        add_slab_sample (record.coords_, centers);
+    }
+
+    int axis = 0;
+    std::vector<T> bounds = slab_bounds (centers, num_buckets, axis);
+    T margin = kernel_margin<T> (kernel_);
+
+    std::vector<std::unique_ptr<buffered_file_t>> out {};
+    for (std::size_t bucket = 0; bucket <= bounds.size (); ++bucket)
+    {
+        buckets.push_back ({ temporary_file_path (directory_), 0 });
+        out.push_back (std::make_unique<buffered_file_t> (buckets.back ().first, "wb", file_buffer_size_));
+    }
+
+    bool ok = std::all_of (out.begin (), out.end (), [] (const auto& file) { return file->is_open (); }) &&
+              std::fseek (in.get (), 0, SEEK_SET) == 0;
+    std::vector<record_t> records {};
+    while (ok && read_records (in.get (), records) && !records.empty ())
+    {
+        for (const auto& tmp : records)
+        {
+            std::pair<std::size_t, std::size_t> slabs = slab_range (tmp.coords_, axis, margin, bounds);
+            for (std::size_t bucket = slabs.first; bucket <= slabs.second && ok; ++bucket)
+            {
+                ok = (std::fwrite (&tmp, sizeof (tmp), 1, out[bucket]->get ()) == 1);
+                buckets[bucket].second++;
+            }
+        }
+    }
+    ok = ok && !std::ferror (in.get ());
+
+    for (auto& file : out)
+        ok = file->close () && ok;
+
+    if (!ok)
+    {
+        for (const auto& bucket : buckets)
+            std::remove (bucket.first.c_str ());
+    }
+    return ok;
+}
+
+// the next OUT_OF_CORE_READ_RECORDS records at most, none at the end of the file
+template <typename T>
+bool basic_out_of_core_t<T>::read_records (std::FILE* file, std::vector<record_t>& records)
+{
+    records.resize (OUT_OF_CORE_READ_RECORDS);
+    records.resize (std::fread (records.data (), sizeof (record_t), records.size (), file));
+    return !std::ferror (file);
+}
+
+template <typename T>
+bool basic_out_of_core_t<T>::verify_bucket (const std::string& path, std::size_t num_triangles)
+{
+    std::vector<std::uint64_t> nums {};
+    std::vector<T> coords {};
+    {
+        buffered_file_t in (path, "rb", file_buffer_size_);
+        if (!in.is_open ())
+            return false;
+
+        nums.reserve (num_triangles);
+        coords.reserve (9 * num_triangles);
+        std::vector<record_t> records {};
+        while (read_records (in.get (), records) && !records.empty ())
+        {
+            for (const auto& tmp : records)
+            {
+                nums.push_back (tmp.num_);
+                coords.insert (coords.end (), tmp.coords_, tmp.coords_ + 9);
+            }
+        }
+        if (std::ferror (in.get ()))
+            return false;
+    }
+    std::remove (path.c_str ());
+
+    stats_.num_buckets_++;
+    stats_.num_bucket_triangles_ += nums.size ();
+    stats_.max_bucket_triangles_ = std::max (stats_.max_bucket_triangles_, nums.size ());
+
+    std::vector<triangle_t> array_triangle = build_triangles (coords, pool_);
+    std::vector<T> ().swap (coords);
+
+    basic_octree_t<T> tree (array_triangle, pool_);
+    tree.set_kernel (kernel_);
+    std::vector<unsigned char> flags = tree.get_intersection_flags (pool_);
+    if (std::find (flags.begin (), flags.end (), 1) == flags.end ())
+        return true;
+
+    // the records keep the order of the input, the numbers are sorted
+    result_paths_.push_back (temporary_file_path (directory_));
+    buffered_file_t out (result_paths_.back (), "wb", file_buffer_size_);
+    bool ok = out.is_open ();
+    for (std::size_t i = 0; i < flags.size () && ok; ++i)
+    {
+        if (flags[i])
+            ok = (std::fwrite (&nums[i], sizeof (nums[i]), 1, out.get ()) == 1);
+    }
+    return out.close () && ok;
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------SCALAR_TYPES----------------------------------------
+
+using out_of_core_t = basic_out_of_core_t<double>;
+
+extern template class basic_out_of_core_t<float>;
+extern template class basic_out_of_core_t<double>;
+extern template class basic_out_of_core_t<long double>;
+
+// ----------------------------------------------------------------------------------
+
+#endif // OUT_OF_CORE_HPP
@@ -0,0 +1,72 @@
+#ifndef OUTPUT_HPP
+#define OUTPUT_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// The numbers of the intersecting triangles come as flags, one byte per triangle
+// (octree_t::get_intersection_flags). They are formatted into one buffer, which is
+// written with one call instead of one stream insertion per number.
+
+// ------------------------------OUTPUT_FORMAT_T-------------------------------------
+
+// text:   the numbers in decimal, one per line
+// uint32: the numbers as packed uint32_t in the byte order of the machine
+// bitmap: bit num % 8 of byte num / 8 is set if the triangle num intersects,
+//         (N + 7) / 8 bytes
+enum class output_format_t { text, uint32, bitmap };
+
+const char* output_format_name (output_format_t format);
+bool output_format_from_name (const std::string& name, output_format_t& format);
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------FORMATTING------------------------------------------
+
+// Appends the numbers with a nonzero flag to buffer. False if a number does not fit
+// into uint32_t, nothing is appended then.
+bool format_intersections (const std::vector<unsigned char>& flags, output_format_t format,
+                           std::vector<char>& buffer);
+
+// The header of a scene in the output of many scenes: the number of the nonzero
+// flags, as a line in text and as one uint32_t in uint32. Nothing in bitmap, the
+// reader knows the number of triangles.
+void format_batch_header (const std::vector<unsigned char>& flags, output_format_t format,
+                          std::vector<char>& buffer);
+
+// the whole buffer with one fwrite, false on an error of the file
+bool write_buffer (std::FILE* file, const std::vector<char>& buffer);
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------NUMBER_WRITER_T-------------------------------------
+
+// The numbers of the intersecting triangles one at a time in increasing order, for
+// results too large to be kept as flags; the output is the one of format_intersections.
+// The buffer is written when it grows over NUMBER_WRITER_BUFFER_SIZE bytes.
+class number_writer_t
+{
+private:
+    std::FILE* file_;
+    output_format_t format_;
+    std::size_t num_triangles_;
+    std::vector<char> buffer_ {};
+    std::size_t num_written_ = 0; // bytes of the bitmap before buffer_
+    bool ok_ = true;
+
+    bool flush ();
+
+public:
+    number_writer_t (std::FILE* file, output_format_t format, std::size_t num_triangles);
+
+    // False on an error of the file or if num does not fit into uint32, the writer
+    // stays failed then.
+    bool add (std::size_t num);
+    // the rest of the buffer and, in bitmap, the zero bytes up to num_triangles
+    bool finish ();
+};
+
+// ----------------------------------------------------------------------------------
+
+#endif // OUTPUT_HPP
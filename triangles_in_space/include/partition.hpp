@@ -0,0 +1,70 @@
+#ifndef PARTITION_HPP
+#define PARTITION_HPP
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// the slab boundaries are quantiles of the centers of at most PARTITION_SAMPLE_SIZE triangles
+const std::size_t PARTITION_SAMPLE_SIZE = 4096;
+
+// ------------------------------SLABS-----------------------------------------------
+
+// A scene is cut into slabs along one axis, each one holding about the same number of
+// triangles. A triangle whose bounding box, widened by margin, crosses a boundary
+// belongs to every slab it touches, so every pair whose boxes are at most margin apart
+// along the axis meets in a slab: with kernel_margin these are all the pairs the kernel
+// can report (the epsilon kernel rejects boxes farther apart, see boxes_near). A
+// triangle is given by its 9 coordinates v.
+
+// the sample of slab_bounds: twice the center of the bounding box of v along every axis
+template <typename T>
+void add_slab_sample (const T* v, std::vector<std::vector<T>>& centers)
+{
+    centers.resize (3);
+    for (int i = 0; i < 3; ++i)
+        centers[i].push_back (std::min ({ v[i], v[3 + i], v[6 + i] }) + std::max ({ v[i], v[3 + i], v[6 + i] }));
+}
+
+// Boundaries of num_slabs slabs along the longest axis of the sample; the sample is
+// sorted along it. The point c lies in the slab upper_bound (bounds, c) - bounds.begin ().
+template <typename T>
+std::vector<T> slab_bounds (std::vector<std::vector<T>>& centers, std::size_t num_slabs, int& axis)
+{
+    axis = 0;
+    std::vector<T> bounds {};
+    if (centers.size () != 3 || centers[0].empty ())
+        return bounds;
+
+    T max_extent = -1;
+    for (int i = 0; i < 3; ++i)
+    {
+        auto range = std::minmax_element (centers[i].begin (), centers[i].end ());
+        if (*range.second - *range.first > max_extent)
+        {
+            max_extent = *range.second - *range.first;
+            axis = i;
+        }
+    }
+
+    std::vector<T>& sample = centers[axis];
+    std::sort (sample.begin (), sample.end ());
+    for (std::size_t slab = 1; slab < num_slabs; ++slab)
+        bounds.push_back (sample[slab * sample.size () / num_slabs] / 2);
+    return bounds;
+}
+
+// the first and the last slab touched by the triangle v
+template <typename T>
+std::pair<std::size_t, std::size_t> slab_range (const T* v, int axis, T margin, const std::vector<T>& bounds)
+{
+    v += axis;
+    T low  = std::min ({ v[0], v[3], v[6] }) - margin;
+    T high = std::max ({ v[0], v[3], v[6] }) + margin;
+    return { static_cast<std::size_t> (std::upper_bound (bounds.begin (), bounds.end (), low) - bounds.begin ()),
+             static_cast<std::size_t> (std::upper_bound (bounds.begin (), bounds.end (), high) - bounds.begin ()) };
+}
+
+// ----------------------------------------------------------------------------------
+
+#endif // PARTITION_HPP
@@ -0,0 +1,285 @@
+#ifndef PREDICATES_HPP
+#define PREDICATES_HPP
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+// Orientation predicates after J. R. Shewchuk, "Adaptive Precision Floating-Point
+// Arithmetic and Fast Robust Geometric Predicates". The determinant is evaluated in
+// doubles first, its sign is returned if it is larger than the proven bound of the
+// rounding error. Otherwise it is evaluated again exactly with floating-point
+// expansions, so the sign is always the sign of the exact determinant.
+// Overflow and underflow are not handled.
+
+namespace predicates
+{
+
+const double UNIT_ROUNDOFF = 0x1.0p-53;
+
+// bounds of the error of the double evaluation, relative to the permanent
+const double ORIENT2D_ERROR_BOUND = (3 + 16 * UNIT_ROUNDOFF) * UNIT_ROUNDOFF;
+const double ORIENT3D_ERROR_BOUND = (7 + 56 * UNIT_ROUNDOFF) * UNIT_ROUNDOFF;
+
+// ------------------------------EXPANSION_T-----------------------------------------
+
+// Exact sum of up to N doubles: nonoverlapping components in increasing order of
+// magnitude, without zeros. The sign of the sum is the sign of the last component.
+template <std::size_t N>
+struct expansion_t
+{
+    std::array<double, N> c_ {};
+    std::size_t size_ = 0;
+
+    double sign () const { return (size_ == 0) ? 0 : c_[size_ - 1]; }
+    void push (double component) { if (component != 0) c_[size_++] = component; }
+};
+
+// x + y = a + b exactly
+inline void two_sum (double a, double b, double& x, double& y)
+{
+    x = a + b;
+    double b_virtual = x - a;
+    double a_virtual = x - b_virtual;
+    y = (a - a_virtual) + (b - b_virtual);
+}
+
+// x + y = a - b exactly
+inline void two_diff (double a, double b, double& x, double& y)
+{
+    x = a - b;
+    double b_virtual = a - x;
+    double a_virtual = x + b_virtual;
+    y = (a - a_virtual) + (b_virtual - b);
+}
+
+// x + y = a * b exactly, fma is exact whatever the contraction flags are
+inline void two_product (double a, double b, double& x, double& y)
+{
+    x = a * b;
+    y = std::fma (a, b, -x);
+}
+
+inline expansion_t<2> diff (double a, double b)
+{
+    double x = 0, y = 0;
+    two_diff (a, b, x, y);
+
+    expansion_t<2> e {};
+    e.push (y);
+    e.push (x);
+    return e;
+}
+
+// e += b in place (Shewchuk, GROW-EXPANSION with zero elimination),
+// e must have room for one more component
+template <std::size_t N>
+void grow (expansion_t<N>& e, double b)
+{
+    std::size_t size = e.size_;
+    e.size_ = 0;
+
+    // component i is read before anything is written at index i or later
+    double q = b;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        double q_new = 0, component = 0;
+        two_sum (q, e.c_[i], q_new, component);
+        e.push (component);
+        q = q_new;
+    }
+    e.push (q);
+}
+
+// h += f, h must have room for f.size_ more components
+template <std::size_t R, std::size_t N>
+void add (expansion_t<R>& h, const expansion_t<N>& f)
+{
+    for (std::size_t i = 0; i < f.size_; ++i)
+        grow (h, f.c_[i]);
+}
+
+template <std::size_t N, std::size_t M>
+expansion_t<N + M> sum (const expansion_t<N>& e, const expansion_t<M>& f)
+{
+    expansion_t<N + M> h {};
+    for (std::size_t i = 0; i < e.size_; ++i)
+        h.c_[i] = e.c_[i];
+    h.size_ = e.size_;
+
+    add (h, f);
+    return h;
+}
+
+template <std::size_t N>
+expansion_t<N> negate (expansion_t<N> e)
+{
+    for (std::size_t i = 0; i < e.size_; ++i)
+        e.c_[i] = -e.c_[i];
+    return e;
+}
+
+// e * b (Shewchuk, SCALE-EXPANSION with zero elimination)
+template <std::size_t N>
+expansion_t<2 * N> scale (const expansion_t<N>& e, double b)
+{
+    expansion_t<2 * N> h {};
+    if (e.size_ == 0)
+        return h;
+
+    double q = 0, component = 0;
+    two_product (e.c_[0], b, q, component);
+    h.push (component);
+
+    for (std::size_t i = 1; i < e.size_; ++i)
+    {
+        double product_hi = 0, product_lo = 0, sum_hi = 0;
+        two_product (e.c_[i], b, product_hi, product_lo);
+        two_sum (q, product_lo, sum_hi, component);
+        h.push (component);
+
+        // fast two sum, |product_hi| >= |sum_hi|
+        q = product_hi + sum_hi;
+        h.push (sum_hi - (q - product_hi));
+    }
+    h.push (q);
+    return h;
+}
+
+template <std::size_t N, std::size_t M>
+expansion_t<2 * N * M> product (const expansion_t<N>& e, const expansion_t<M>& f)
+{
+    expansion_t<2 * N * M> h {};
+    for (std::size_t i = 0; i < f.size_; ++i)
+        add (h, scale (e, f.c_[i]));
+    return h;
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------ORIENTATION-----------------------------------------
+
+// (ax - cx) * (by - cy) - (ay - cy) * (bx - cx) exactly
+inline double orient2d_exact (double ax, double ay, double bx, double by, double cx, double cy)
+{
+    expansion_t<8> left  = product (diff (ax, cx), diff (by, cy));
+    expansion_t<8> right = product (diff (ay, cy), diff (bx, cx));
+    return sum (left, negate (right)).sign ();
+}
+
+// Positive if a, b, c go counterclockwise, negative if clockwise, zero if they
+// are collinear. The sign is exact, the value is an approximation of twice the
+// signed area.
+inline double orient2d (double ax, double ay, double bx, double by, double cx, double cy)
+{
+    double det_left  = (ax - cx) * (by - cy);
+    double det_right = (ay - cy) * (bx - cx);
+    double det = det_left - det_right;
+
+    if (std::fabs (det) >= ORIENT2D_ERROR_BOUND * (std::fabs (det_left) + std::fabs (det_right)))
+        return det;
+
+    return orient2d_exact (ax, ay, bx, by, cx, cy);
+}
+
+// the same determinant as orient3d, exactly
+inline double orient3d_exact (double ax, double ay, double az, double bx, double by, double bz,
+                              double cx, double cy, double cz, double dx, double dy, double dz)
+{
+    expansion_t<2> ux = diff (bx, ax), uy = diff (by, ay), uz = diff (bz, az);
+    expansion_t<2> vx = diff (cx, ax), vy = diff (cy, ay), vz = diff (cz, az);
+    expansion_t<2> wx = diff (dx, ax), wy = diff (dy, ay), wz = diff (dz, az);
+
+    // u . (v x w)
+    expansion_t<16> x = sum (product (vy, wz), negate (product (vz, wy)));
+    expansion_t<16> y = sum (product (vz, wx), negate (product (vx, wz)));
+    expansion_t<16> z = sum (product (vx, wy), negate (product (vy, wx)));
+
+    expansion_t<192> det = sum (sum (product (x, ux), product (y, uy)), product (z, uz));
+    return det.sign ();
+}
+
+// det [b - a, c - a, d - a] = ((b - a) x (c - a), d - a). Positive if d lies on the
+// side of the plane abc the normal (b - a) x (c - a) points to, zero if the four
+// points are coplanar. The sign is exact.
+inline double orient3d (double ax, double ay, double az, double bx, double by, double bz,
+                        double cx, double cy, double cz, double dx, double dy, double dz)
+{
+    double ux = bx - ax, uy = by - ay, uz = bz - az;
+    double vx = cx - ax, vy = cy - ay, vz = cz - az;
+    double wx = dx - ax, wy = dy - ay, wz = dz - az;
+
+    double vy_wz = vy * wz, vz_wy = vz * wy;
+    double vz_wx = vz * wx, vx_wz = vx * wz;
+    double vx_wy = vx * wy, vy_wx = vy * wx;
+
+    double det = ux * (vy_wz - vz_wy) + uy * (vz_wx - vx_wz) + uz * (vx_wy - vy_wx);
+    double permanent = (std::fabs (vy_wz) + std::fabs (vz_wy)) * std::fabs (ux) +
+                       (std::fabs (vz_wx) + std::fabs (vx_wz)) * std::fabs (uy) +
+                       (std::fabs (vx_wy) + std::fabs (vy_wx)) * std::fabs (uz);
+
+    // a zero permanent means zero differences, the determinant is exactly zero
+    if (std::fabs (det) > ORIENT3D_ERROR_BOUND * permanent || permanent == 0)
+        return det;
+
+    return orient3d_exact (ax, ay, az, bx, by, bz, cx, cy, cz, dx, dy, dz);
+}
+
+// ------------------------------ORIENT3D_PLANE_T------------------------------------
+
+// orient3d (a, b, c, d) for many points d against one plane. The determinant is
+// expanded along d - a, so the minors and their permanents are computed once; the
+// expression has the form of the one in orient3d and the same error bound.
+class orient3d_plane_t
+{
+private:
+    double ax_, ay_, az_, bx_, by_, bz_, cx_, cy_, cz_;
+    double minor_x_, minor_y_, minor_z_;
+    double permanent_x_, permanent_y_, permanent_z_;
+
+public:
+    orient3d_plane_t (double ax, double ay, double az, double bx, double by, double bz,
+                      double cx, double cy, double cz);
+
+    double operator() (double dx, double dy, double dz) const;
+};
+
+inline orient3d_plane_t::orient3d_plane_t (double ax, double ay, double az, double bx, double by, double bz,
+                                           double cx, double cy, double cz) :
+    ax_ (ax), ay_ (ay), az_ (az), bx_ (bx), by_ (by), bz_ (bz), cx_ (cx), cy_ (cy), cz_ (cz)
+{
+    double ux = bx - ax, uy = by - ay, uz = bz - az;
+    double vx = cx - ax, vy = cy - ay, vz = cz - az;
+
+    double uy_vz = uy * vz, uz_vy = uz * vy;
+    double uz_vx = uz * vx, ux_vz = ux * vz;
+    double ux_vy = ux * vy, uy_vx = uy * vx;
+
+    minor_x_ = uy_vz - uz_vy;
+    minor_y_ = uz_vx - ux_vz;
+    minor_z_ = ux_vy - uy_vx;
+
+    permanent_x_ = std::fabs (uy_vz) + std::fabs (uz_vy);
+    permanent_y_ = std::fabs (uz_vx) + std::fabs (ux_vz);
+    permanent_z_ = std::fabs (ux_vy) + std::fabs (uy_vx);
+}
+
+inline double orient3d_plane_t::operator() (double dx, double dy, double dz) const
+{
+    double wx = dx - ax_, wy = dy - ay_, wz = dz - az_;
+
+    double det = wx * minor_x_ + wy * minor_y_ + wz * minor_z_;
+    double permanent = std::fabs (wx) * permanent_x_ + std::fabs (wy) * permanent_y_ +
+                       std::fabs (wz) * permanent_z_;
+
+    if (std::fabs (det) > ORIENT3D_ERROR_BOUND * permanent || permanent == 0)
+        return det;
+
+    return orient3d_exact (ax_, ay_, az_, bx_, by_, bz_, cx_, cy_, cz_, dx, dy, dz);
+}
+
+// ----------------------------------------------------------------------------------
+
+} // namespace predicates
+
+#endif // PREDICATES_HPP
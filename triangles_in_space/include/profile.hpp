@@ -0,0 +1,190 @@
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+
+// Counting and timing of the branches of triangle_t::check_intersection.
+// Enabled by defining TRIANGLES_PROFILE (cmake -DTRIANGLES_PROFILE=ON), otherwise
+// the macros below expand to nothing.
+
+#ifdef TRIANGLES_PROFILE
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <set>
+
+enum class branch_t
+{
+    same_sign_rejection,
+    general_position,
+    coplanar,
+    line_line,
+    point_point,
+    line_point,
+    triangle_line,
+    triangle_point,
+    different_degeneracies, // different degeneracies that do not touch
+    count
+};
+
+const char* const BRANCH_NAMES[] = { "same_sign_rejection", "general_position", "coplanar",
+                                     "line_line", "point_point", "line_point", "triangle_line",
+                                     "triangle_point", "different_degeneracies" };
+
+const std::size_t NUM_BRANCHES = static_cast<std::size_t> (branch_t::count);
+
+struct branch_counts_t
+{
+    std::array<std::uint64_t, NUM_BRANCHES> calls_ {};
+    std::array<std::uint64_t, NUM_BRANCHES> ns_ {};
+
+    void add (const branch_counts_t& other)
+    {
+        for (std::size_t i = 0; i < NUM_BRANCHES; ++i)
+        {
+            calls_[i] += other.calls_[i];
+            ns_[i]    += other.ns_[i];
+        }
+    }
+};
+
+// ------------------------------BRANCH_PROFILE_T------------------------------------
+
+// Every thread counts into its own thread_local counts without synchronization.
+// They are registered here, so a report sums the live threads and the threads
+// that have already finished.
+class branch_profile_t
+{
+private:
+    std::mutex mutex_ {};
+    std::set<const branch_counts_t*> live_counts_ {};
+    branch_counts_t finished_counts_ {};
+
+    struct thread_counts_t
+    {
+        branch_counts_t counts_ {};
+        thread_counts_t () { instance ().attach (&counts_); }
+        ~thread_counts_t () { instance ().detach (&counts_); }
+    };
+
+    void attach (const branch_counts_t* counts)
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        live_counts_.insert (counts);
+    }
+
+    void detach (const branch_counts_t* counts)
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        finished_counts_.add (*counts);
+        live_counts_.erase (counts);
+    }
+
+public:
+    static branch_profile_t& instance ()
+    {
+        static branch_profile_t profile {};
+        return profile;
+    }
+
+    static branch_counts_t& thread_counts ()
+    {
+        thread_local thread_counts_t counts {};
+        return counts.counts_;
+    }
+
+    // counts of other running threads are read without synchronization,
+    // call it when the work is done
+    branch_counts_t get_counts ()
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        branch_counts_t counts = finished_counts_;
+        for (auto tmp : live_counts_)
+            counts.add (*tmp);
+        return counts;
+    }
+
+    void print (std::ostream& out)
+    {
+        branch_counts_t counts = get_counts ();
+        std::uint64_t total_calls = 0;
+        for (auto tmp : counts.calls_)
+            total_calls += tmp;
+
+        out << "check_intersection branches (calls, share, total ms, ns/call):\n";
+        for (std::size_t i = 0; i < NUM_BRANCHES; ++i)
+        {
+            if (counts.calls_[i] == 0)
+                continue;
+
+            out << "  " << std::left << std::setw (24) << BRANCH_NAMES[i] << std::right
+                << std::setw (12) << counts.calls_[i]
+                << std::setw (9) << std::fixed << std::setprecision (2)
+                << 100.0 * counts.calls_[i] / total_calls << "%"
+                << std::setw (12) << counts.ns_[i] / 1e6
+                << std::setw (10) << static_cast<double> (counts.ns_[i]) / counts.calls_[i] << "\n";
+        }
+        out.unsetf (std::ios::floatfield);
+    }
+};
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------BRANCH_TIMER_T--------------------------------------
+
+// Measures one check_intersection call, the branch is set by the code it runs
+class branch_timer_t
+{
+private:
+    branch_t branch_ = branch_t::different_degeneracies;
+    std::chrono::steady_clock::time_point start_ {};
+    branch_timer_t* previous_ = nullptr;
+
+public:
+    static branch_timer_t*& current ()
+    {
+        thread_local branch_timer_t* timer = nullptr;
+        return timer;
+    }
+
+    branch_timer_t () : start_ (std::chrono::steady_clock::now ()), previous_ (current ())
+    {
+        current () = this;
+    }
+
+    ~branch_timer_t ()
+    {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds> (
+                      std::chrono::steady_clock::now () - start_).count ();
+
+        branch_counts_t& counts = branch_profile_t::thread_counts ();
+        counts.calls_[static_cast<std::size_t> (branch_)]++;
+        counts.ns_[static_cast<std::size_t> (branch_)] += ns;
+        current () = previous_;
+    }
+
+    branch_timer_t (const branch_timer_t&) = delete;
+    branch_timer_t& operator= (const branch_timer_t&) = delete;
+
+    static void set_branch (branch_t branch)
+    {
+        if (current ())
+            current ()->branch_ = branch;
+    }
+};
+
+// ----------------------------------------------------------------------------------
+
+    #define TRIANGLES_PROFILE_SCOPE()        branch_timer_t branch_timer_ {}
+    #define TRIANGLES_PROFILE_BRANCH(branch) branch_timer_t::set_branch (branch_t::branch)
+
+#else
+
+    #define TRIANGLES_PROFILE_SCOPE()
+    #define TRIANGLES_PROFILE_BRANCH(branch)
+
+#endif // TRIANGLES_PROFILE
+
+#endif // PROFILE_HPP
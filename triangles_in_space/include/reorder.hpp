@@ -0,0 +1,136 @@
+#ifndef REORDER_HPP
+#define REORDER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+#include "triangles.hpp"
+
+// bits of every coordinate of a Morton code, 3 * 21 = 63
+const unsigned MORTON_BITS = 21;
+const std::size_t REORDER_BLOCK_SIZE = 4096;
+// the codes are sorted by digits of RADIX_BITS bits
+const unsigned RADIX_BITS = 16;
+
+// ------------------------------MORTON----------------------------------------------
+
+// the lower MORTON_BITS bits of v moved to every third bit
+inline std::uint64_t spread_bits (std::uint64_t v)
+{
+    v &= (std::uint64_t (1) << MORTON_BITS) - 1;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8)  & 0x100f00f00f00f00fULL;
+    v = (v | v << 4)  & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2)  & 0x1249249249249249ULL;
+    return v;
+}
+
+inline std::uint64_t morton_code (std::uint32_t x, std::uint32_t y, std::uint32_t z)
+{
+    return spread_bits (x) | (spread_bits (y) << 1) | (spread_bits (z) << 2);
+}
+
+// LSD radix sort of (code, num) pairs by the codes; a digit equal in every code is skipped
+inline void radix_sort (std::vector<std::pair<std::uint64_t, std::size_t>>& keys)
+{
+    const std::uint64_t mask = (std::uint64_t (1) << RADIX_BITS) - 1;
+    std::vector<std::pair<std::uint64_t, std::size_t>> buffer (keys.size ());
+
+    for (unsigned shift = 0; shift < 3 * MORTON_BITS; shift += RADIX_BITS)
+    {
+        std::vector<std::size_t> position ((std::size_t (1) << RADIX_BITS) + 1);
+        for (const auto& key : keys)
+            position[((key.first >> shift) & mask) + 1]++;
+
+        if (std::find (position.begin (), position.end (), keys.size ()) != position.end ())
+            continue;
+
+        for (std::size_t digit = 1; digit < position.size (); ++digit)
+            position[digit] += position[digit - 1];
+
+        for (const auto& key : keys)
+            buffer[position[(key.first >> shift) & mask]++] = key;
+        keys.swap (buffer);
+    }
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------REORDER---------------------------------------------
+
+// Renumbers the triangles along the Morton curve through the centers of their boxes.
+// The octree keeps the order of the numbers in every leaf, so the triangles of a leaf
+// end up close to each other in memory. Returns the permutation: the triangle num of
+// the new order is the triangle order[num] of the old one.
+template <typename T>
+std::vector<std::size_t> reorder_morton (std::vector<basic_triangle_t<T>>& array_triangle, thread_pool_t& pool)
+{
+    std::size_t N = array_triangle.size ();
+    std::vector<std::size_t> order (N);
+    if (N == 0)
+        return order;
+
+    // twice the centers, the common factor does not change the order
+    auto center = [&] (std::size_t num)
+    {
+        return array_triangle[num].get_p_min () + array_triangle[num].get_p_max ();
+    };
+
+    basic_point_t<T> low = center (0), high = center (0);
+    for (std::size_t num = 1; num < N; ++num)
+    {
+        basic_point_t<T> c = center (num);
+        low  = basic_point_t<T> (std::min (low.x_, c.x_), std::min (low.y_, c.y_), std::min (low.z_, c.z_));
+        high = basic_point_t<T> (std::max (high.x_, c.x_), std::max (high.y_, c.y_), std::max (high.z_, c.z_));
+    }
+
+    // one scale for the three axes, the cells stay cubes
+    T extent = std::max ({ high.x_ - low.x_, high.y_ - low.y_, high.z_ - low.z_ });
+    T scale = (extent > 0) ? T ((std::uint32_t (1) << MORTON_BITS) - 1) / extent : T (0);
+
+    std::vector<std::pair<std::uint64_t, std::size_t>> keys (N);
+    std::size_t num_blocks = (N + REORDER_BLOCK_SIZE - 1) / REORDER_BLOCK_SIZE;
+    pool.parallel_for (0, num_blocks, [&] (std::size_t block)
+    {
+        std::size_t end = std::min ((block + 1) * REORDER_BLOCK_SIZE, N);
+        for (std::size_t num = block * REORDER_BLOCK_SIZE; num < end; ++num)
+        {
+            basic_point_t<T> cell = (center (num) - low) * scale;
+            keys[num] = { morton_code (static_cast<std::uint32_t> (cell.x_), static_cast<std::uint32_t> (cell.y_),
+                                       static_cast<std::uint32_t> (cell.z_)), num };
+        }
+    });
+    radix_sort (keys);
+
+    std::vector<basic_triangle_t<T>> reordered (N);
+    pool.parallel_for (0, num_blocks, [&] (std::size_t block)
+    {
+        std::size_t end = std::min ((block + 1) * REORDER_BLOCK_SIZE, N);
+        for (std::size_t num = block * REORDER_BLOCK_SIZE; num < end; ++num)
+        {
+            order[num] = keys[num].second;
+            reordered[num] = array_triangle[keys[num].second];
+        }
+    });
+
+    array_triangle.swap (reordered);
+    return order;
+}
+
+// flags of the old numbers from the flags of the new ones
+inline std::vector<unsigned char> restore_order (const std::vector<unsigned char>& flags,
+                                                 const std::vector<std::size_t>& order)
+{
+    std::vector<unsigned char> restored (flags.size ());
+    for (std::size_t num = 0; num < flags.size (); ++num)
+        restored[order[num]] = flags[num];
+    return restored;
+}
+
+// ----------------------------------------------------------------------------------
+
+#endif // REORDER_HPP
@@ -0,0 +1,319 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <istream>
+#include <map>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "thread_pool.hpp"
+#include "triangles.hpp"
+#include "octree.hpp"
+#include "output.hpp"
+
+// Requests are whitespace separated tokens, the coordinates are written as in the
+// input of the program (9 numbers per triangle):
+//   scene NAME N <N triangles>   uploads the scene NAME, replacing an old one
+//   add NAME N <N triangles>     appends triangles, their numbers follow the old ones
+//   set NAME NUM <triangle>      replaces the triangle NUM
+//   remove NAME NUM              removes the triangle NUM, the next numbers shift by one
+//   query NAME                   numbers of the intersecting triangles of the scene
+//   query_triangle NAME <triangle>  numbers of the triangles intersecting the given one
+//   stats NAME                   octree statistics of the last query
+//   drop NAME
+//   quit
+// Every response starts with "ok LATENCY NUM_LINES" followed by NUM_LINES lines, or
+// is the single line "error LATENCY MESSAGE". LATENCY is the processing time in
+// microseconds, without reading the request and writing the response. Edits respond
+// with the new number of triangles of the scene.
+
+// ------------------------------SCENE_T---------------------------------------------
+
+// The tree is built by the first query after an edit and kept for the next ones.
+template <typename T>
+class basic_scene_t
+{
+public:
+    using triangle_t = basic_triangle_t<T>;
+    using octree_t   = basic_octree_t<T>;
+
+private:
+    std::vector<triangle_t> array_triangle_ {};
+    std::unique_ptr<octree_t> tree_ {}; // refers to array_triangle_
+
+public:
+    std::vector<triangle_t>& edit () { tree_.reset (); return array_triangle_; }
+    std::size_t size () const { return array_triangle_.size (); }
+    bool has_tree () const { return tree_ != nullptr; }
+
+    const octree_t& get_tree (thread_pool_t& pool, kernel_t kernel);
+};
+
+template <typename T>
+inline const basic_octree_t<T>& basic_scene_t<T>::get_tree (thread_pool_t& pool, kernel_t kernel)
+{
+    if (!tree_)
+        tree_ = std::make_unique<octree_t> (array_triangle_, pool);
+
+    tree_->set_kernel (kernel);
+    return *tree_;
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------SERVER_T--------------------------------------------
+
+template <typename T>
+class basic_server_t
+{
+public:
+    using point_t    = basic_point_t<T>;
+    using triangle_t = basic_triangle_t<T>;
+    using scene_t    = basic_scene_t<T>;
+
+private:
+    thread_pool_t& pool_;
+    kernel_t kernel_;
+    std::map<std::string, scene_t> scenes_ {};
+    std::vector<T> coords_ {}; // reused by every upload
+    std::vector<char> output_buffer_ {};
+    bool quit_ = false;
+
+    bool allocate_triangles (std::size_t num);
+    // the coordinates of the triangles allocated by allocate_triangles
+    bool read_triangles (std::istream& in);
+    static bool read_triangle (std::istream& in, triangle_t& tr);
+    scene_t* find_scene (const std::string& name);
+
+public:
+    basic_server_t (thread_pool_t& pool, kernel_t kernel = DEFAULT_KERNEL) : pool_ (pool), kernel_ (kernel) {}
+
+    // answers one request; false on quit, on the end of input or on a request that
+    // cannot be parsed (the rest of the stream cannot be trusted then)
+    bool handle (std::istream& in, std::ostream& out);
+    // answers the requests until handle returns false or out fails (the client is gone),
+    // true if it was stopped by quit
+    bool serve (std::istream& in, std::ostream& out);
+
+    std::size_t get_num_scenes () const { return scenes_.size (); }
+};
+
+// false if the coordinates of num triangles do not fit into memory
+template <typename T>
+inline bool basic_server_t<T>::allocate_triangles (std::size_t num)
+{
+    if (num > coords_.max_size () / 9)
+        return false;
+
+    try
+    {
+        coords_.resize (9 * num);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+inline bool basic_server_t<T>::read_triangles (std::istream& in)
+{
+    for (auto& tmp : coords_)
+        in >> tmp;
+
+    return static_cast<bool> (in);
+}
+
+template <typename T>
+inline bool basic_server_t<T>::read_triangle (std::istream& in, triangle_t& tr)
+{
+    point_t a {}, b {}, c {};
+    if (!(in >> a >> b >> c))
+        return false;
+
+    tr = triangle_t (a, b, c);
+    return true;
+}
+
+template <typename T>
+inline basic_scene_t<T>* basic_server_t<T>::find_scene (const std::string& name)
+{
+    auto it = scenes_.find (name);
+    return (it == scenes_.end ()) ? nullptr : &it->second;
+}
+
+template <typename T>
+inline bool basic_server_t<T>::handle (std::istream& in, std::ostream& out)
+{
+    std::string command, name;
+    if (!(in >> command))
+        return false;
+
+    if (command == "quit")
+    {
+        quit_ = true;
+        return false;
+    }
+
+    if (!(in >> name))
+    {
+        out << "error 0 " << command << " without a scene name\n";
+        return false;
+    }
+
+    // the payload is read before the clock starts
+    std::size_t num = 0;
+    triangle_t tr {};
+    bool parsed = true;
+    if (command == "scene" || command == "add")
+    {
+        parsed = static_cast<bool> (in >> num);
+        if (parsed && !allocate_triangles (num))
+        {
+            // the payload is not read, the rest of the stream is not a request
+            out << "error 0 cannot allocate " << num << " triangles\n";
+            return false;
+        }
+        parsed = parsed && read_triangles (in);
+    }
+    else if (command == "set")
+        parsed = (in >> num) && read_triangle (in, tr);
+    else if (command == "remove")
+        parsed = static_cast<bool> (in >> num);
+    else if (command == "query_triangle")
+        parsed = read_triangle (in, tr);
+    else if (command != "query" && command != "stats" && command != "drop")
+    {
+        out << "error 0 unknown request " << command << "\n";
+        return false;
+    }
+
+    if (!parsed)
+    {
+        out << "error 0 cannot parse " << command << " " << name << "\n";
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now ();
+    std::vector<std::string> lines {};
+    std::set<std::size_t> nums {};
+    std::vector<unsigned char> flags {};
+    std::string error {};
+
+    scene_t* scene = (command == "scene") ? &scenes_[name] : find_scene (name);
+    if (!scene)
+        error = "unknown scene " + name;
+    else if (command == "scene")
+    {
+        scene->edit () = build_triangles (coords_, pool_);
+        lines.push_back (std::to_string (scene->size ()));
+    }
+    else if (command == "add")
+    {
+        std::vector<triangle_t> added = build_triangles (coords_, pool_);
+        std::vector<triangle_t>& array_triangle = scene->edit ();
+        array_triangle.insert (array_triangle.end (), added.begin (), added.end ());
+        lines.push_back (std::to_string (scene->size ()));
+    }
+    else if ((command == "set" || command == "remove") && num >= scene->size ())
+        error = "no triangle " + std::to_string (num) + " in " + name;
+    else if (command == "set")
+    {
+        scene->edit ()[num] = tr;
+        lines.push_back (std::to_string (scene->size ()));
+    }
+    else if (command == "remove")
+    {
+        std::vector<triangle_t>& array_triangle = scene->edit ();
+        array_triangle.erase (array_triangle.begin () + num);
+        lines.push_back (std::to_string (scene->size ()));
+    }
+    else if (command == "query")
+    {
+        flags = scene->get_tree (pool_, kernel_).get_intersection_flags (pool_);
+    }
+    else if (command == "query_triangle")
+    {
+        nums = scene->get_tree (pool_, kernel_).get_num_tr_intersection (tr);
+    }
+    else if (command == "stats")
+    {
+        if (!scene->has_tree ())
+            error = "scene " + name + " was not queried since the last edit";
+        else
+        {
+            std::stringstream stats;
+            stats << scene->get_tree (pool_, kernel_).get_stats ();
+            for (std::string line; std::getline (stats, line);)
+                lines.push_back (line);
+        }
+    }
+    else
+        scenes_.erase (name);
+
+    long latency = std::chrono::duration_cast<std::chrono::microseconds> (
+        std::chrono::steady_clock::now () - start).count ();
+
+    if (!error.empty ())
+    {
+        out << "error " << latency << " " << error << std::endl;
+        return true;
+    }
+
+    std::size_t num_flags = std::count (flags.begin (), flags.end (), 1);
+    out << "ok " << latency << " " << lines.size () + nums.size () + num_flags << "\n";
+    for (const auto& line : lines)
+        out << line << "\n";
+    for (auto tmp : nums)
+        out << tmp << "\n";
+
+    output_buffer_.clear ();
+    format_intersections (flags, output_format_t::text, output_buffer_);
+    out.write (output_buffer_.data (), output_buffer_.size ());
+    out.flush ();
+    return true;
+}
+
+template <typename T>
+inline bool basic_server_t<T>::serve (std::istream& in, std::ostream& out)
+{
+    quit_ = false;
+    while (handle (in, out) && out)
+        ;
+
+    out.flush ();
+    return quit_;
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------UNIX_SOCKET-----------------------------------------
+
+// Listens on the unix socket at path and calls serve (in, out) for the connections one
+// after another until serve returns true. Returns false if the socket cannot be opened,
+// if path exists and is not a socket (it is left as it is) or if accept fails.
+bool serve_unix_socket (const std::string& path, const std::function<bool (std::istream&, std::ostream&)>& serve);
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------SCALAR_TYPES----------------------------------------
+
+using scene_t  = basic_scene_t<double>;
+using server_t = basic_server_t<double>;
+
+extern template class basic_server_t<float>;
+extern template class basic_server_t<double>;
+extern template class basic_server_t<long double>;
+
+// ----------------------------------------------------------------------------------
+
+#endif // SERVER_HPP
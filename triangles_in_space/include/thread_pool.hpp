@@ -0,0 +1,154 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const std::size_t CHUNKS_PER_THREAD = 4;
+
+// ------------------------------THREAD_POOL_T---------------------------------------
+
+// The workers stay alive between calls, so a pool can be shared by many queries.
+// The thread that calls parallel_for also runs tasks while waiting, which makes
+// nested parallel_for calls (from inside a task) safe.
+class thread_pool_t
+{
+private:
+    std::vector<std::thread> workers_ {};
+    std::deque<std::function<void ()>> tasks_ {};
+    std::mutex mutex_ {};
+    std::condition_variable task_cv_ {};
+    std::condition_variable done_cv_ {};
+    bool stop_ = false;
+
+    void worker_loop (const std::function<void ()>& init_worker);
+    bool run_pending_task (std::unique_lock<std::mutex>& lock);
+
+public:
+    explicit thread_pool_t (std::size_t num_threads = std::thread::hardware_concurrency ());
+    // every worker calls init_worker () once before taking tasks, e.g. to pin itself
+    thread_pool_t (std::size_t num_threads, std::function<void ()> init_worker);
+    ~thread_pool_t ();
+
+    thread_pool_t (const thread_pool_t&) = delete;
+    thread_pool_t& operator= (const thread_pool_t&) = delete;
+
+    std::size_t get_num_threads () const { return workers_.size () + 1; }
+
+    // calls func (i) for every i in [begin, end)
+    template <typename F>
+    void parallel_for (std::size_t begin, std::size_t end, F func);
+};
+
+inline thread_pool_t::thread_pool_t (std::size_t num_threads) : thread_pool_t (num_threads, {}) {}
+
+inline thread_pool_t::thread_pool_t (std::size_t num_threads, std::function<void ()> init_worker)
+{
+    num_threads = std::max (num_threads, static_cast<std::size_t> (1));
+    for (std::size_t i = 1; i < num_threads; ++i)
+    {
+        workers_.emplace_back ([this, init_worker] { worker_loop (init_worker); });
+    }
+}
+
+inline thread_pool_t::~thread_pool_t ()
+{
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        stop_ = true;
+    }
+    task_cv_.notify_all ();
+
+    for (auto& worker : workers_)
+    {
+        worker.join ();
+    }
+}
+
+inline void thread_pool_t::worker_loop (const std::function<void ()>& init_worker)
+{
+    if (init_worker)
+        init_worker ();
+
+    std::unique_lock<std::mutex> lock (mutex_);
+    while (true)
+    {
+        task_cv_.wait (lock, [this] { return stop_ || !tasks_.empty (); });
+        if (stop_ && tasks_.empty ())
+            return;
+
+        run_pending_task (lock);
+    }
+}
+
+// lock is held on entry and on exit, the task itself runs unlocked
+inline bool thread_pool_t::run_pending_task (std::unique_lock<std::mutex>& lock)
+{
+    if (tasks_.empty ())
+        return false;
+
+    std::function<void ()> task = std::move (tasks_.front ());
+    tasks_.pop_front ();
+
+    lock.unlock ();
+    task ();
+    lock.lock ();
+
+    return true;
+}
+
+template <typename F>
+void thread_pool_t::parallel_for (std::size_t begin, std::size_t end, F func)
+{
+    if (begin >= end)
+        return;
+
+    std::size_t num_chunks = std::min (end - begin, get_num_threads () * CHUNKS_PER_THREAD);
+    if (workers_.empty () || num_chunks <= 1)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+            func (i);
+        return;
+    }
+
+    std::size_t chunk_size = (end - begin + num_chunks - 1) / num_chunks;
+    num_chunks = (end - begin + chunk_size - 1) / chunk_size;
+    std::atomic<std::size_t> remaining { num_chunks };
+
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        for (std::size_t chunk_begin = begin; chunk_begin < end; chunk_begin += chunk_size)
+        {
+            std::size_t chunk_end = std::min (chunk_begin + chunk_size, end);
+            tasks_.emplace_back ([this, &func, &remaining, chunk_begin, chunk_end]
+            {
+                for (std::size_t i = chunk_begin; i < chunk_end; ++i)
+                    func (i);
+
+                if (--remaining == 0)
+                {
+                    std::lock_guard<std::mutex> done_lock (mutex_);
+                    done_cv_.notify_all ();
+                }
+            });
+        }
+    }
+    task_cv_.notify_all ();
+
+    std::unique_lock<std::mutex> lock (mutex_);
+    while (remaining != 0)
+    {
+        if (!run_pending_task (lock))
+            done_cv_.wait (lock, [&] { return remaining == 0 || !tasks_.empty (); });
+    }
+}
+
+// ----------------------------------------------------------------------------------
+
+#endif // THREAD_POOL_HPP
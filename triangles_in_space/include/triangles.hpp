@@ -1,146 +1,323 @@
 #ifndef TRIANGLES_HPP
 #define TRIANGLES_HPP
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <iostream>
+#include <limits>
+#include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
-const double EPSILON = 1e-7;
+#include "predicates.hpp"
+#include "profile.hpp"
+#include "thread_pool.hpp"
 
-// ------------------------------POINT_T---------------------------------------------
+// the square root of a positive x by Newton's method, for the constants below
+template <typename T>
+constexpr T constexpr_sqrt (T x)
+{
+    T root = 1;
+    for (int i = 0; i < 128; ++i)
+        root = (root + x / root) / 2;
+    return root;
+}
 
-struct point_t
+// Tolerance of the epsilon kernel for a scalar type: 1e-7 for double, for another type
+// scaled by the square root of the ratio of the machine epsilons, so it stays the same
+// multiple (about 6.7) of sqrt (numeric_limits<T>::epsilon ()); 2.3e-3 for float and
+// 2.2e-9 for the 64 bit mantissa of x87 long double
+template <typename T>
+struct tolerance_t
 {
-    double x_ = NAN;
-    double y_ = NAN;
-    double z_ = NAN;
+    static_assert (std::is_floating_point<T>::value, "tolerance_t needs a floating point type");
+    static constexpr T epsilon = T (1e-7) * constexpr_sqrt (std::numeric_limits<T>::epsilon () /
+                                                            T (std::numeric_limits<double>::epsilon ()));
+};
+
+constexpr double EPSILON = tolerance_t<double>::epsilon;
+static_assert (EPSILON == 1e-7, "the rule of tolerance_t keeps the tolerance of double");
+const std::size_t BUILD_BLOCK_SIZE = 1024;
+
+// degeneracy classification of a triangle with the tolerance EPSILON, the exact one is
+// robust_degenerate_tr and robust_triangle_is_point
+const unsigned char DEGENERATE_TR     = 1;
+const unsigned char TRIANGLE_IS_POINT = 2;
+
+// how check_intersection decides the signs of its tests
+enum class kernel_t
+{
+    epsilon,         // values closer to zero than EPSILON are zero
+    robust,          // exact signs of the orientation predicates (predicates.hpp)
+    guigue_devillers // the robust kernel with the test of Guigue and Devillers
+                     // for triangles in general position
+};
 
-    point_t () { };
-    point_t (double x, double y, double z) : x_ { x }, y_ { y }, z_ { z } { };
+const kernel_t ALL_KERNELS[] = { kernel_t::epsilon, kernel_t::robust, kernel_t::guigue_devillers };
+
+// the kernel used when none is given (cmake -DTRIANGLES_KERNEL=robust)
+#ifndef TRIANGLES_DEFAULT_KERNEL
+    #define TRIANGLES_DEFAULT_KERNEL epsilon
+#endif
+
+const kernel_t DEFAULT_KERNEL = kernel_t::TRIANGLES_DEFAULT_KERNEL;
+
+// the reach of a kernel: it never reports a pair whose bounding boxes are farther
+// apart than the margin along an axis (boxes_near), so a bounding box filter of its
+// pairs widens the boxes by it; EPSILON for the epsilon kernel, 0 for the exact ones
+template <typename T>
+constexpr T kernel_margin (kernel_t kernel)
+{
+    return (kernel == kernel_t::epsilon) ? tolerance_t<T>::epsilon : T (0);
+}
+
+// defined in src/triangles.cpp
+std::string kernel_name (kernel_t kernel);
+bool kernel_from_name (const std::string& name, kernel_t& kernel);
+
+// ------------------------------POINT_T---------------------------------------------
 
-    point_t operator+(const point_t& p) const { return { x_ + p.x_, y_ + p.y_, z_ + p.z_ }; }
-    point_t operator-(const point_t& p) const { return { x_ - p.x_, y_ - p.y_, z_ - p.z_ }; }
-    point_t operator*(double k) const { return { x_ * k, y_ * k, z_ * k }; }
-    point_t operator/(double k) const { return { x_ / k, y_ / k, z_ / k };}
-    void operator=(const point_t& p) { x_ = p.x_; y_ = p.y_; z_ = p.z_; }
-    bool operator==(const point_t& p) const 
+template <typename T>
+struct basic_point_t
+{
+    T x_ = NAN;
+    T y_ = NAN;
+    T z_ = NAN;
+
+    constexpr basic_point_t () { };
+    constexpr basic_point_t (T x, T y, T z) : x_ { x }, y_ { y }, z_ { z } { };
+
+    constexpr basic_point_t operator+(const basic_point_t& p) const { return { x_ + p.x_, y_ + p.y_, z_ + p.z_ }; }
+    constexpr basic_point_t operator-(const basic_point_t& p) const { return { x_ - p.x_, y_ - p.y_, z_ - p.z_ }; }
+    constexpr basic_point_t operator*(T k) const { return { x_ * k, y_ * k, z_ * k }; }
+    constexpr basic_point_t operator/(T k) const { return { x_ / k, y_ / k, z_ / k };}
+    constexpr bool operator==(const basic_point_t& p) const 
     { 
-        return (std::fabs (x_ - p.x_) < EPSILON && 
-                std::fabs (y_ - p.y_) < EPSILON &&
-                std::fabs (z_ - p.z_) < EPSILON);
+        return (near (x_, p.x_) && near (y_, p.y_) && near (z_, p.z_));
+    }
+
+    constexpr T get_x () const { return x_; }
+    constexpr T get_y () const { return y_; }
+    constexpr T get_z () const { return z_; }
+
+    // coordinate 0, 1 or 2
+    template <int axis>
+    constexpr T get () const
+    {
+        static_assert (axis >= 0 && axis < 3, "axis is 0, 1 or 2");
+        if constexpr (axis == 0)
+            return x_;
+        else if constexpr (axis == 1)
+            return y_;
+        else
+            return z_;
     }
 
-    double get_x () const { return x_; }
-    double get_y () const { return y_; }
-    double get_z () const { return z_; }
+    // |a - b| < the tolerance of T, false for NAN
+    static constexpr bool near (T a, T b)
+    {
+        return (a - b < tolerance_t<T>::epsilon && b - a < tolerance_t<T>::epsilon);
+    }
 };
 
 // ----------------------------------------------------------------------------------
 
 // ------------------------------VECTOR_T--------------------------------------------
 
-class vector_t
+template <typename T>
+class basic_vector_t
 {
-    double x_ = NAN;
-    double y_ = NAN;
-    double z_ = NAN;
+    T x_ = NAN;
+    T y_ = NAN;
+    T z_ = NAN;
 
 public:
-    vector_t () { };
-    vector_t (double x, double y, double z) : x_ { x }, y_ { y }, z_ { z } { };
-    vector_t (const point_t& a, const point_t& b);
+    constexpr basic_vector_t () { };
+    constexpr basic_vector_t (T x, T y, T z) : x_ { x }, y_ { y }, z_ { z } { };
+    constexpr basic_vector_t (const basic_point_t<T>& a, const basic_point_t<T>& b);
 
-    double get_x () const { return x_; }
-    double get_y () const { return y_; }
-    double get_z () const { return z_; }
+    constexpr T get_x () const { return x_; }
+    constexpr T get_y () const { return y_; }
+    constexpr T get_z () const { return z_; }
 
-    vector_t cross_product (const vector_t& b) const;
-    double scalar_product (const vector_t& b) const;
-    bool zero_vector () const 
+    constexpr basic_vector_t cross_product (const basic_vector_t& b) const;
+    constexpr T scalar_product (const basic_vector_t& b) const;
+    constexpr bool zero_vector () const 
     {
-        return ((std::fabs (x_) < EPSILON) &&
-                (std::fabs (y_) < EPSILON) && 
-                (std::fabs (z_) < EPSILON));
+        return (basic_point_t<T>::near (x_, 0) && basic_point_t<T>::near (y_, 0) &&
+                basic_point_t<T>::near (z_, 0));
     }
 };
 
-inline vector_t::vector_t (const point_t& a, const point_t& b)
-{
-    x_ = b.x_ - a.x_;
-    y_ = b.y_ - a.y_;
-    z_ = b.z_ - a.z_;
-}
+template <typename T>
+constexpr basic_vector_t<T>::basic_vector_t (const basic_point_t<T>& a, const basic_point_t<T>& b) :
+    x_ { b.x_ - a.x_ }, y_ { b.y_ - a.y_ }, z_ { b.z_ - a.z_ } { }
 
-inline vector_t vector_t::cross_product (const vector_t& b) const
+template <typename T>
+constexpr basic_vector_t<T> basic_vector_t<T>::cross_product (const basic_vector_t& b) const
 {
-    vector_t c;
-    c.x_ = y_ * b.z_ - z_ * b.y_;
-    c.y_ = z_ * b.x_ - x_ * b.z_;
-    c.z_ = x_ * b.y_ - y_ * b.x_;
-    return c;
+    return { y_ * b.z_ - z_ * b.y_,
+             z_ * b.x_ - x_ * b.z_,
+             x_ * b.y_ - y_ * b.x_ };
 }
 
-inline double vector_t::scalar_product (const vector_t& b) const
+template <typename T>
+constexpr T basic_vector_t<T>::scalar_product (const basic_vector_t& b) const
 {
     return x_ * b.x_ + y_ * b.y_ + z_ * b.z_;
 }
 
 // ----------------------------------------------------------------------------------
 
+// ------------------------------RAY_T-----------------------------------------------
+
+// points origin_ + direction_ * t, 0 <= t <= t_max_
+template <typename T>
+struct basic_ray_t
+{
+    basic_point_t<T> origin_ {};
+    basic_vector_t<T> direction_ {};
+    T t_max_ = INFINITY;
+
+    constexpr basic_ray_t () { };
+    constexpr basic_ray_t (const basic_point_t<T>& origin, const basic_vector_t<T>& direction, T t_max = INFINITY) :
+        origin_ { origin }, direction_ { direction }, t_max_ { t_max } { };
+
+    static constexpr basic_ray_t segment (const basic_point_t<T>& p1, const basic_point_t<T>& p2)
+    {
+        return { p1, { p1, p2 }, 1 };
+    }
+    constexpr basic_point_t<T> get_point (T t) const 
+    { 
+        return origin_ + basic_point_t<T> (direction_.get_x (), direction_.get_y (), direction_.get_z ()) * t;
+    }
+};
+
+// ----------------------------------------------------------------------------------
+
 // ------------------------------TRIANGLE_T------------------------------------------
 
-class triangle_t
+template <typename T>
+class basic_triangle_t
 {
+public:
+    using point_t  = basic_point_t<T>;
+    using vector_t = basic_vector_t<T>;
+    using ray_t    = basic_ray_t<T>;
+
+    // the tolerance of the epsilon kernel
+    static constexpr T EPSILON = tolerance_t<T>::epsilon;
+
+private:
     point_t a_ {};
     point_t b_ {};
     point_t c_ {};
 
     vector_t N_; // the plane equation (N, X - a) = 0
+    vector_t n_; // N / |N|, zero only if N is exactly zero, not for every DEGENERATE_TR
 
     point_t p_min_ {};
     point_t p_max_ {};
 
-public:
-    triangle_t () { };
-    triangle_t (const point_t& a, const point_t& b, const point_t& c);
-
-    point_t get_a () const { return a_; }
-    point_t get_b () const { return b_; }
-    point_t get_c () const { return c_; }
-    vector_t get_N () const { return N_; }
+    unsigned char flags_ = 0; // DEGENERATE_TR | TRIANGLE_IS_POINT
 
-    double distance_point_plane_tr (const point_t& p) const;
+public:
+    constexpr basic_triangle_t () { };
+    basic_triangle_t (const point_t& a, const point_t& b, const point_t& c);
+
+    const point_t& get_a () const { return a_; }
+    const point_t& get_b () const { return b_; }
+    const point_t& get_c () const { return c_; }
+    const vector_t& get_N () const { return N_; }
+    const vector_t& get_n () const { return n_; }
+    const point_t& get_p_min () const { return p_min_; }
+    const point_t& get_p_max () const { return p_max_; }
+    unsigned char get_flags () const { return flags_; }
+
+    T distance_point_plane_tr (const point_t& p) const;
     bool point_lie_in_plane_tr (const point_t& p) const;
-    bool degenerate_tr () const;
-    bool triangle_is_point () const { return ((a_ == b_) && (a_ == c_)); }
+    bool degenerate_tr () const { return (flags_ & DEGENERATE_TR); }
+    bool triangle_is_point () const { return (flags_ & TRIANGLE_IS_POINT); }
     bool triangle_is_line () const { return (degenerate_tr() && !triangle_is_point()); }
     bool triangle_lie_in_space (const point_t& p1, const point_t& p2) const;
-
-    bool check_intersection (const triangle_t& other) const;
-    bool check_same_sign_distance (const triangle_t& other) const;
-    bool check_intersection_tr_of_line (const triangle_t& other) const ;
-    std::pair<double, double> projection (char axis, const triangle_t& other) const;
+    // the bounding boxes are at most margin apart along every axis
+    bool boxes_near (const basic_triangle_t& other, T margin) const;
+
+    bool check_intersection (const basic_triangle_t& other, kernel_t kernel = DEFAULT_KERNEL) const;
+    bool check_intersection_ray (const ray_t& ray, T& t) const;
+    point_t closest_point (const point_t& p) const;
+    static point_t closest_point_segment (const point_t& p1, const point_t& p2, const point_t& p);
+    T distance (const basic_triangle_t& other) const;
+    static T distance_segment_segment (const point_t& line1_p1, const point_t& line1_p2,
+                                            const point_t& line2_p1, const point_t& line2_p2);
+    // signed distances from a_, b_, c_ to the plane of other
+    std::array<T, 3> distances_to_plane (const basic_triangle_t& other) const;
+    static bool same_sign (const std::array<T, 3>& distances);
+    bool check_same_sign_distance (const basic_triangle_t& other) const;
+    bool check_intersection_tr_of_line (const basic_triangle_t& other) const ;
+    bool check_intersection_tr_of_line (const basic_triangle_t& other, const std::array<T, 3>& distances,
+                                        const std::array<T, 3>& other_distances) const;
+    template <int axis>
+    bool check_intervals_overlap (const basic_triangle_t& other, const std::array<T, 3>& distances,
+                                  const std::array<T, 3>& other_distances) const;
+    std::pair<T, T> projection (char axis, const basic_triangle_t& other) const;
+    template <int axis>
+    std::pair<T, T> projection (const std::array<T, 3>& distances) const;
     bool check_triangle_point (const point_t& p) const;
     bool check_triangle_line (const point_t& p1, const point_t& p2) const;
     static bool check_line_point (const point_t& line_p1, const point_t& line_p2, const point_t& p);
     static bool check_point_point (const point_t& p1, const point_t& p2);
     static bool check_line_line (const point_t& line1_p1, const point_t& line1_p2,
                       const point_t& line2_p1, const point_t& line2_p2);
-    bool check_different_degeneracies (const triangle_t& other) const;
-    static std::pair<point_t, point_t> select_ends_segment (const point_t& p1, 
+    bool check_different_degeneracies (const basic_triangle_t& other) const;
+    // points to two of the arguments, they must outlive the result
+    static std::pair<const point_t*, const point_t*> select_ends_segment (const point_t& p1, 
                               const point_t& p2, const point_t& p3);
-};
 
-inline bool triangle_t::degenerate_tr () const
-{
-    return ((std::fabs(N_.get_x()) < EPSILON) &&
-            (std::fabs(N_.get_y()) < EPSILON) && 
-            (std::fabs(N_.get_z()) < EPSILON));
-}
+    // kernel_t::robust, every sign is exact and nothing is compared with EPSILON
+    static int orientation (const point_t& a, const point_t& b, const point_t& c, const point_t& d);
+    static double orientation_2d (const point_t& a, const point_t& b, const point_t& c, int drop_axis);
+    static bool collinear (const point_t& a, const point_t& b, const point_t& c);
+    static int projection_axis (const point_t& a, const point_t& b, const point_t& c);
+    static bool same_point (const point_t& p1, const point_t& p2);
+    static bool check_line_point_robust (const point_t& line_p1, const point_t& line_p2, const point_t& p);
+    static bool check_line_line_robust (const point_t& line1_p1, const point_t& line1_p2,
+                                        const point_t& line2_p1, const point_t& line2_p2);
+    static std::pair<const point_t*, const point_t*> select_ends_segment_robust (const point_t& p1, 
+                              const point_t& p2, const point_t& p3);
+    bool check_triangle_point_robust (const point_t& p) const;
+    // side_1, side_2 are the orientations of p1, p2 to the plane of the triangle
+    bool check_triangle_line_robust (const point_t& p1, const point_t& p2, int side_1, int side_2) const;
+    bool check_triangle_line_robust (const point_t& p1, const point_t& p2) const;
+    void plane_sides (const basic_triangle_t& other, int& side_a, int& side_b, int& side_c) const;
+    bool check_coplanar_robust (const basic_triangle_t& other) const;
+    bool check_intersection_robust (const basic_triangle_t& other) const;
+
+    // kernel_t::guigue_devillers, p1 and p2 are alone on their sides of the other plane
+    static bool check_intervals_overlap_gd (const point_t& p1, const point_t& q1, const point_t& r1,
+                                            const point_t& p2, const point_t& q2, const point_t& r2);
+    static bool check_turned_gd (const point_t& p1, const point_t& q1, const point_t& r1,
+                                 const point_t& p2, const point_t& q2, const point_t& r2,
+                                 int side_p2, int side_q2, int side_r2);
+    bool check_intersection_guigue_devillers (const basic_triangle_t& other) const;
+    // exact, computed on every call: only the robust kernels need them
+    bool robust_degenerate_tr () const { return collinear (a_, b_, c_); }
+    bool robust_triangle_is_point () const { return (same_point (a_, b_) && same_point (a_, c_)); }
+};
 
-inline triangle_t::triangle_t (const point_t& a, const point_t& b, const point_t& c) : 
+// Everything a pair test of the epsilon kernel needs is derived here once per triangle:
+// the normal, the unit normal, the bounding box and the degeneracy flags. The exact
+// classification of the robust kernels is left to them.
+template <typename T>
+inline basic_triangle_t<T>::basic_triangle_t (const point_t& a, const point_t& b, const point_t& c) : 
     a_(a), b_(b), c_(c), N_(vector_t ({ a, b }).cross_product ({ a, c }))
 {
+    T norm = std::sqrt (N_.scalar_product (N_));
+    norm = (norm > 0) ? norm : 1;
+    n_ = vector_t (N_.get_x () / norm, N_.get_y () / norm, N_.get_z () / norm);
+
     p_min_.x_ = std::min(a_.x_, std::min (b_.x_, c_.x_));
     p_min_.y_ = std::min(a_.y_, std::min (b_.y_, c_.y_));
     p_min_.z_ = std::min(a_.z_, std::min (b_.z_, c_.z_));
@@ -148,31 +325,37 @@ inline triangle_t::triangle_t (const point_t& a, const point_t& b, const point_t
     p_max_.x_ = std::max(a_.x_, std::max (b_.x_, c_.x_));
     p_max_.y_ = std::max(a_.y_, std::max (b_.y_, c_.y_));
     p_max_.z_ = std::max(a_.z_, std::max (b_.z_, c_.z_));
+
+    if (N_.zero_vector ())
+        flags_ |= DEGENERATE_TR;
+    if ((a_ == b_) && (a_ == c_))
+        flags_ |= TRIANGLE_IS_POINT;
 }
 
-inline double triangle_t::distance_point_plane_tr (const point_t& p) const
+template <typename T>
+inline T basic_triangle_t<T>::distance_point_plane_tr (const point_t& p) const
 {
     vector_t vec { a_, p };
-    double res  = N_.scalar_product (vec);
-    double norm = std::sqrt (N_.scalar_product (N_));
-    return res / norm;
+    return n_.scalar_product (vec);
 }
 
-inline bool triangle_t::point_lie_in_plane_tr (const point_t& p) const
+template <typename T>
+inline bool basic_triangle_t<T>::point_lie_in_plane_tr (const point_t& p) const
 {
     return (std::fabs (distance_point_plane_tr (p)) < EPSILON);
 }
 
-inline bool triangle_t::triangle_lie_in_space(const point_t& p1, const point_t& p2) const
+template <typename T>
+inline bool basic_triangle_t<T>::triangle_lie_in_space(const point_t& p1, const point_t& p2) const
 {
-    double cube_min_x = std::min(p1.x_, p2.x_);
-    double cube_max_x = std::max(p1.x_, p2.x_);
+    T cube_min_x = std::min(p1.x_, p2.x_);
+    T cube_max_x = std::max(p1.x_, p2.x_);
 
-    double cube_min_y = std::min(p1.y_, p2.y_);
-    double cube_max_y = std::max(p1.y_, p2.y_);
+    T cube_min_y = std::min(p1.y_, p2.y_);
+    T cube_max_y = std::max(p1.y_, p2.y_);
 
-    double cube_min_z = std::min(p1.z_, p2.z_);
-    double cube_max_z = std::max(p1.z_, p2.z_);
+    T cube_min_z = std::min(p1.z_, p2.z_);
+    T cube_max_z = std::max(p1.z_, p2.z_);
 
     bool overlap_x = !(p_max_.x_ < cube_min_x || p_min_.x_ > cube_max_x);
     bool overlap_y = !(p_max_.y_ < cube_min_y || p_min_.y_ > cube_max_y);
@@ -181,91 +364,324 @@ inline bool triangle_t::triangle_lie_in_space(const point_t& p1, const point_t&
     return overlap_x && overlap_y && overlap_z;
 }
 
-inline bool triangle_t::check_intersection (const triangle_t& other) const
+template <typename T>
+inline bool basic_triangle_t<T>::boxes_near (const basic_triangle_t& other, T margin) const
+{
+    return !(p_max_.x_ + margin < other.p_min_.x_ || other.p_max_.x_ + margin < p_min_.x_ ||
+             p_max_.y_ + margin < other.p_min_.y_ || other.p_max_.y_ + margin < p_min_.y_ ||
+             p_max_.z_ + margin < other.p_min_.z_ || other.p_max_.z_ + margin < p_min_.z_);
+}
+
+template <typename T>
+inline bool basic_triangle_t<T>::check_intersection (const basic_triangle_t& other, kernel_t kernel) const
 {
-    if (other.check_same_sign_distance (*this) || 
-        check_same_sign_distance (other))
+    TRIANGLES_PROFILE_SCOPE ();
+
+    if (kernel == kernel_t::robust)
+        return check_intersection_robust (other);
+    if (kernel == kernel_t::guigue_devillers)
+        return check_intersection_guigue_devillers (other);
+
+    // The tests below compare values of different scales with EPSILON, check_triangle_point
+    // one scaled by |N|^2, so for small triangles they would accept pairs much farther
+    // apart than EPSILON. The boxes bound the reach of the kernel by kernel_margin.
+    if (!boxes_near (other, EPSILON))
+        return false;
+
+    // every vertex distance of the pair is computed once here and reused below
+    std::array<T, 3> other_distances = other.distances_to_plane (*this);
+    bool rejected = (!degenerate_tr () && same_sign (other_distances));
+
+    std::array<T, 3> distances {};
+    if (!rejected)
+    {
+        distances = distances_to_plane (other);
+        rejected  = (!other.degenerate_tr () && same_sign (distances));
+    }
+
+    if (rejected)
     {
+        TRIANGLES_PROFILE_BRANCH (same_sign_rejection);
         return false; // one of the triangles lies completely in the half-plane of
                       // the other
     }
 
     // non-degenerate triangles
     if (!degenerate_tr () && !other.degenerate_tr ())
-        return check_intersection_tr_of_line (other);
+    {
+        TRIANGLES_PROFILE_BRANCH (general_position);
+        return check_intersection_tr_of_line (other, distances, other_distances);
+    }
 
     // the same kind of degeneracy
     if (triangle_is_line () && other.triangle_is_line ())
     {
-        std::pair<point_t, point_t> pair1 = select_ends_segment (a_, b_, c_);
-        std::pair<point_t, point_t> pair2 = select_ends_segment (
-                                        other.get_a (), other.get_b (), other.get_c ());
-        return check_line_line (pair1.first, pair1.second, pair2.first, pair2.second);
+        TRIANGLES_PROFILE_BRANCH (line_line);
+        auto pair1 = select_ends_segment (a_, b_, c_);
+        auto pair2 = select_ends_segment (other.get_a (), other.get_b (), other.get_c ());
+        return check_line_line (*pair1.first, *pair1.second, *pair2.first, *pair2.second);
     }
 
     if (triangle_is_point () && other.triangle_is_point ())
+    {
+        TRIANGLES_PROFILE_BRANCH (point_point);
         return check_point_point (a_, other.get_a ());
+    }
 
     // different kinds of degeneracy
     return (check_different_degeneracies (other) || 
             other.check_different_degeneracies (*this));
 }
 
-inline bool triangle_t::check_different_degeneracies (const triangle_t& other) const 
+// Only the crossing of the plane of a non-degenerate triangle is a hit, a ray lying
+// in the plane does not hit it. On success t is the ray parameter of the hit.
+template <typename T>
+inline bool basic_triangle_t<T>::check_intersection_ray (const ray_t& ray, T& t) const
+{
+    if (degenerate_tr ())
+        return false;
+
+    T denominator = N_.scalar_product (ray.direction_);
+    if (denominator == 0)
+        return false;
+
+    T t_plane = N_.scalar_product (vector_t{ ray.origin_, a_ }) / denominator;
+    if (t_plane < 0 || t_plane > ray.t_max_)
+        return false;
+
+    if (!check_triangle_point (ray.get_point (t_plane)))
+        return false;
+
+    t = t_plane;
+    return true;
+}
+
+// the point of the triangle nearest to p (Ericson, Real-Time Collision Detection, 5.1.5)
+template <typename T>
+inline basic_point_t<T> basic_triangle_t<T>::closest_point (const point_t& p) const
+{
+    if (triangle_is_point ())
+        return a_;
+
+    if (degenerate_tr ())
+    {
+        auto pair = select_ends_segment (a_, b_, c_);
+        return closest_point_segment (*pair.first, *pair.second, p);
+    }
+
+    vector_t ab { a_, b_ };
+    vector_t ac { a_, c_ };
+
+    // vertex region a_
+    vector_t ap { a_, p };
+    T d1 = ab.scalar_product (ap);
+    T d2 = ac.scalar_product (ap);
+    if (d1 <= 0 && d2 <= 0)
+        return a_;
+
+    // vertex region b_
+    vector_t bp { b_, p };
+    T d3 = ab.scalar_product (bp);
+    T d4 = ac.scalar_product (bp);
+    if (d3 >= 0 && d4 <= d3)
+        return b_;
+
+    // edge region a_b_
+    T vc = d1 * d4 - d3 * d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0)
+        return a_ + (b_ - a_) * (d1 / (d1 - d3));
+
+    // vertex region c_
+    vector_t cp { c_, p };
+    T d5 = ab.scalar_product (cp);
+    T d6 = ac.scalar_product (cp);
+    if (d6 >= 0 && d5 <= d6)
+        return c_;
+
+    // edge region a_c_
+    T vb = d5 * d2 - d1 * d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0)
+        return a_ + (c_ - a_) * (d2 / (d2 - d6));
+
+    // edge region b_c_
+    T va = d3 * d6 - d5 * d4;
+    if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+        return b_ + (c_ - b_) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    // inside the face
+    T denominator = 1 / (va + vb + vc);
+    return a_ + (b_ - a_) * (vb * denominator) + (c_ - a_) * (vc * denominator);
+}
+
+template <typename T>
+inline basic_point_t<T> basic_triangle_t<T>::closest_point_segment (const point_t& p1, const point_t& p2, const point_t& p)
+{
+    vector_t u { p1, p2 };
+    T u_u = u.scalar_product (u);
+    if (u_u == 0)
+        return p1;
+
+    T t = u.scalar_product (vector_t{ p1, p }) / u_u;
+    t = std::min (std::max (t, T (0)), T (1));
+    return p1 + (p2 - p1) * t;
+}
+
+// If the triangles do not intersect, the nearest points lie either on a vertex of one
+// triangle or on a pair of edges
+template <typename T>
+inline T basic_triangle_t<T>::distance (const basic_triangle_t& other) const
+{
+    if (check_intersection (other))
+        return 0;
+
+    const point_t* verts_1[] = { &a_, &b_, &c_ };
+    const point_t* verts_2[] = { &other.get_a (), &other.get_b (), &other.get_c () };
+
+    T min_squared = INFINITY;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        vector_t vec_1 { *verts_1[i], other.closest_point (*verts_1[i]) };
+        vector_t vec_2 { *verts_2[i], closest_point (*verts_2[i]) };
+        min_squared = std::min (min_squared, vec_1.scalar_product (vec_1));
+        min_squared = std::min (min_squared, vec_2.scalar_product (vec_2));
+    }
+
+    T min_distance = std::sqrt (min_squared);
+    for (std::size_t i = 0; i < 3; ++i)
+        for (std::size_t j = 0; j < 3; ++j)
+        {
+            min_distance = std::min (min_distance,
+                distance_segment_segment (*verts_1[i], *verts_1[(i + 1) % 3],
+                                          *verts_2[j], *verts_2[(j + 1) % 3]));
+        }
+
+    return min_distance;
+}
+
+// Ericson, Real-Time Collision Detection, 5.1.9
+template <typename T>
+inline T basic_triangle_t<T>::distance_segment_segment (const point_t& line1_p1, const point_t& line1_p2,
+                                                    const point_t& line2_p1, const point_t& line2_p2)
+{
+    vector_t u{ line1_p1, line1_p2 }; // guiding vector line 1
+    vector_t v{ line2_p1, line2_p2 }; // guiding vector line 2
+    vector_t w{ line2_p1, line1_p1 }; // vector between line 2 & line 1
+
+    T u_u = u.scalar_product (u);
+    T v_v = v.scalar_product (v);
+    T v_w = v.scalar_product (w);
+
+    T parameter_1 = 0;
+    T parameter_2 = 0;
+
+    if (u_u == 0 && v_v == 0)
+    {
+        return std::sqrt (w.scalar_product (w));
+    }
+
+    if (u_u == 0)
+    {
+        parameter_2 = std::min (std::max (v_w / v_v, T (0)), T (1));
+    }
+    else
+    {
+        T u_w = u.scalar_product (w);
+        if (v_v == 0)
+        {
+            parameter_1 = std::min (std::max (-u_w / u_u, T (0)), T (1));
+        }
+        else
+        {
+            T u_v = u.scalar_product (v);
+            T denominator = u_u * v_v - u_v * u_v;
+
+            // not parallel lines
+            if (denominator != 0)
+                parameter_1 = std::min (std::max ((u_v * v_w - u_w * v_v) / denominator, T (0)), T (1));
+
+            parameter_2 = (u_v * parameter_1 + v_w) / v_v;
+
+            if (parameter_2 < 0)
+            {
+                parameter_2 = 0;
+                parameter_1 = std::min (std::max (-u_w / u_u, T (0)), T (1));
+            }
+            else if (parameter_2 > 1)
+            {
+                parameter_2 = 1;
+                parameter_1 = std::min (std::max ((u_v - u_w) / u_u, T (0)), T (1));
+            }
+        }
+    }
+
+    point_t line1_parameter1 = line1_p1 + (line1_p2 - line1_p1) * parameter_1;
+    point_t line2_parameter2 = line2_p1 + (line2_p2 - line2_p1) * parameter_2;
+
+    vector_t vec { line1_parameter1, line2_parameter2 };
+    return std::sqrt (vec.scalar_product (vec));
+}
+
+template <typename T>
+inline bool basic_triangle_t<T>::check_different_degeneracies (const basic_triangle_t& other) const 
 {
     if (triangle_is_line () && other.triangle_is_point ())
     {
-        std::pair<point_t, point_t> pair = select_ends_segment (a_, b_, c_);
-        return check_line_point (pair.first, pair.second, other.get_a ());
+        TRIANGLES_PROFILE_BRANCH (line_point);
+        auto pair = select_ends_segment (a_, b_, c_);
+        return check_line_point (*pair.first, *pair.second, other.get_a ());
     }
 
     if (!degenerate_tr () && other.triangle_is_line ())
     {
-        std::pair<point_t, point_t> pair = select_ends_segment (
-                                        other.get_a (), other.get_b (), other.get_c ());
-        return check_triangle_line (pair.first, pair.second);
+        TRIANGLES_PROFILE_BRANCH (triangle_line);
+        auto pair = select_ends_segment (other.get_a (), other.get_b (), other.get_c ());
+        return check_triangle_line (*pair.first, *pair.second);
     }
 
     if (!degenerate_tr () && other.triangle_is_point ())
     {
+        TRIANGLES_PROFILE_BRANCH (triangle_point);
         return check_triangle_point (other.get_a ());
     }
 
     return false;
 }
 
-inline std::pair<point_t, point_t> triangle_t::select_ends_segment (const point_t& p1, 
+template <typename T>
+inline std::pair<const basic_point_t<T>*, const basic_point_t<T>*> basic_triangle_t<T>::select_ends_segment (const point_t& p1, 
                               const point_t& p2, const point_t& p3)
 {
     // c_ lies between a_ & b_
     if (check_line_point (p1, p2, p3)) 
-        return {p1, p2};
+        return {&p1, &p2};
 
     // b_ lies between a_ & c_
     else if (check_line_point (p1, p3, p2))
-        return {p1, p3};
+        return {&p1, &p3};
 
     // a_ lies between b_ & c_
-    return {p2, p3};
+    return {&p2, &p3};
 };
 
-inline bool triangle_t::check_triangle_point (const point_t& p) const
+template <typename T>
+inline bool basic_triangle_t<T>::check_triangle_point (const point_t& p) const
 {
     // guaranteed that point already lies in plane of triangle
-    double res_1 = (vector_t{a_, b_}.cross_product(
+    T res_1 = (vector_t{a_, b_}.cross_product(
                     vector_t{a_, p})).scalar_product(N_); 
 
-    double res_2 = (vector_t{b_, c_}.cross_product(
+    T res_2 = (vector_t{b_, c_}.cross_product(
                     vector_t{b_, p})).scalar_product(N_); 
     
-    double res_3 = (vector_t{c_, a_}.cross_product(
+    T res_3 = (vector_t{c_, a_}.cross_product(
                     vector_t{c_, p})).scalar_product(N_); 
 
     return ((res_1 >= -EPSILON && res_2 >= -EPSILON && res_3 >= -EPSILON) || 
             (res_1 <= EPSILON && res_2 <= EPSILON && res_3 <= EPSILON));
 }
 
-inline bool triangle_t::check_triangle_line (const point_t& p1, const point_t& p2) const
+template <typename T>
+inline bool basic_triangle_t<T>::check_triangle_line (const point_t& p1, const point_t& p2) const
 {
     // guaranteed that line intersects plane of triangle (or lies)
 
@@ -279,7 +695,7 @@ inline bool triangle_t::check_triangle_line (const point_t& p1, const point_t& p
     }
     
     // intersects
-    double t = - N_.scalar_product(vector_t{a_, p1}) /
+    T t = - N_.scalar_product(vector_t{a_, p1}) /
                  N_.scalar_product(vector_t{p1, p2});
 
     point_t p = p1 + ((p2 - p1) * t);
@@ -287,7 +703,8 @@ inline bool triangle_t::check_triangle_line (const point_t& p1, const point_t& p
     return check_triangle_point (p);
 }
 
-inline bool triangle_t::check_line_line (const point_t& line1_p1, const point_t& line1_p2,
+template <typename T>
+inline bool basic_triangle_t<T>::check_line_line (const point_t& line1_p1, const point_t& line1_p2,
                       const point_t& line2_p1, const point_t& line2_p2)
 {
     vector_t u{ line1_p1, line1_p2 }; // guiding vector line 1
@@ -303,15 +720,15 @@ inline bool triangle_t::check_line_line (const point_t& line1_p1, const point_t&
                 check_line_point(line2_p1, line2_p2, line1_p2));
     }
 
-    double u_u = u.scalar_product(u);
-    double u_v = u.scalar_product(v);
-    double v_v = v.scalar_product(v);
-    double u_w = u.scalar_product(w);
-    double v_w = v.scalar_product(w);
+    T u_u = u.scalar_product(u);
+    T u_v = u.scalar_product(v);
+    T v_v = v.scalar_product(v);
+    T u_w = u.scalar_product(w);
+    T v_w = v.scalar_product(w);
 
-    double denominator = u_u * v_v - u_v * u_v;
-    double parameter_1 = (v_v * u_w - u_v * v_w) / denominator;
-    double parameter_2 = (u_v * u_w - u_u * v_w) / denominator;
+    T denominator = u_u * v_v - u_v * u_v;
+    T parameter_1 = (v_v * u_w - u_v * v_w) / denominator;
+    T parameter_2 = (u_v * u_w - u_u * v_w) / denominator;
   
     point_t line1_parameter1 = line1_p1 + (line1_p2 - line1_p1) * parameter_1;
     point_t line2_parameter2 = line2_p1 + (line2_p2 - line2_p1) * parameter_2;
@@ -322,7 +739,8 @@ inline bool triangle_t::check_line_line (const point_t& line1_p1, const point_t&
             (parameter_2 >= -EPSILON) && (parameter_2 <= 1 + EPSILON));
 }
 
-inline bool triangle_t::check_line_point (const point_t& line_p1, const point_t& line_p2, const point_t& p)
+template <typename T>
+inline bool basic_triangle_t<T>::check_line_point (const point_t& line_p1, const point_t& line_p2, const point_t& p)
 {
     vector_t vec1{ line_p1, line_p2 };
     vector_t vec2{ line_p1, p };
@@ -342,26 +760,48 @@ inline bool triangle_t::check_line_point (const point_t& line_p1, const point_t&
             (std::fmax (line_p1.get_z (), line_p2.get_z ()) + EPSILON >= p.get_z ()));
 }
 
-inline bool triangle_t::check_point_point (const point_t& p1, const point_t& p2)
+template <typename T>
+inline bool basic_triangle_t<T>::check_point_point (const point_t& p1, const point_t& p2)
 {
     return (p1 == p2);
 }
 
-inline bool triangle_t::check_same_sign_distance (const triangle_t& other) const
+template <typename T>
+inline std::array<T, 3> basic_triangle_t<T>::distances_to_plane (const basic_triangle_t& other) const
+{
+    return { other.distance_point_plane_tr (a_),
+             other.distance_point_plane_tr (b_),
+             other.distance_point_plane_tr (c_) };
+}
+
+template <typename T>
+inline bool basic_triangle_t<T>::same_sign (const std::array<T, 3>& distances)
+{
+    return ((distances[0] > EPSILON && distances[1] > EPSILON && distances[2] > EPSILON) || 
+            (distances[0] < -EPSILON && distances[1] < -EPSILON && distances[2] < -EPSILON));
+}
+
+template <typename T>
+inline bool basic_triangle_t<T>::check_same_sign_distance (const basic_triangle_t& other) const
 {
     if (other.degenerate_tr())
     {
         return false;
     }
-    double distance_1 = other.distance_point_plane_tr (a_);
-    double distance_2 = other.distance_point_plane_tr (b_);
-    double distance_3 = other.distance_point_plane_tr (c_);
 
-    return ((distance_1 > EPSILON && distance_2 > EPSILON && distance_3 > EPSILON) || 
-            (distance_1 < -EPSILON && distance_2 < -EPSILON && distance_3 < -EPSILON));
+    return same_sign (distances_to_plane (other));
 }
 
-inline bool triangle_t::check_intersection_tr_of_line (const triangle_t& other) const
+template <typename T>
+inline bool basic_triangle_t<T>::check_intersection_tr_of_line (const basic_triangle_t& other) const
+{
+    return check_intersection_tr_of_line (other, distances_to_plane (other), other.distances_to_plane (*this));
+}
+
+template <typename T>
+inline bool basic_triangle_t<T>::check_intersection_tr_of_line (const basic_triangle_t& other, 
+                                                       const std::array<T, 3>& distances,
+                                                       const std::array<T, 3>& other_distances) const
 {
     // D = direction of the common line
     vector_t D = N_.cross_product (other.get_N ());
@@ -369,6 +809,7 @@ inline bool triangle_t::check_intersection_tr_of_line (const triangle_t& other)
     // triangles lie in same plane
     if (D.zero_vector ())
     {
+        TRIANGLES_PROFILE_BRANCH (coplanar);
         return (check_triangle_line (other.get_a (), other.get_b ()) ||
                 check_triangle_line (other.get_a (), other.get_c ()) ||
                 check_triangle_line (other.get_c (), other.get_b ()) ||
@@ -386,115 +827,560 @@ inline bool triangle_t::check_intersection_tr_of_line (const triangle_t& other)
                 other.check_triangle_point (c_));
     }
 
-    double D_x = std::fabs (D.get_x ());
-    double D_y = std::fabs (D.get_y ());
-    double D_z = std::fabs (D.get_z ());
-
-    char axis = 'z';
+    T D_x = std::fabs (D.get_x ());
+    T D_y = std::fabs (D.get_y ());
+    T D_z = std::fabs (D.get_z ());
 
+    // the axis is chosen once, the rest is specialized for it
     if ((D_y - D_x) < EPSILON && (D_z - D_x) < EPSILON)
-        axis = 'x';
-    else if ((D_x - D_y) < EPSILON && (D_z - D_y) < EPSILON)
-        axis = 'y';
+        return check_intervals_overlap<0> (other, distances, other_distances);
+    if ((D_x - D_y) < EPSILON && (D_z - D_y) < EPSILON)
+        return check_intervals_overlap<1> (other, distances, other_distances);
+    return check_intervals_overlap<2> (other, distances, other_distances);
+}
 
-    std::pair<double, double> pair_1 = projection (axis, other);
-    double t1 = pair_1.first;
-    double t2 = pair_1.second;
+template <typename T>
+template <int axis>
+bool basic_triangle_t<T>::check_intervals_overlap (const basic_triangle_t& other, const std::array<T, 3>& distances,
+                                          const std::array<T, 3>& other_distances) const
+{
+    std::pair<T, T> pair_1 = projection<axis> (distances);
+    T t1 = pair_1.first;
+    T t2 = pair_1.second;
 
-    std::pair<double, double> pair_2 = other.projection (axis, *this);
-    double t3 = pair_2.first;
-    double t4 = pair_2.second;
+    std::pair<T, T> pair_2 = other.template projection<axis> (other_distances);
+    T t3 = pair_2.first;
+    T t4 = pair_2.second;
 
     return ((std::min (t1, t2) <= std::max (t3, t4)) && 
             (std::min (t3, t4) <= std::max (t1, t2)));
 }
 
-inline std::pair<double, double> triangle_t::projection (char axis, const triangle_t& other) const
+template <typename T>
+inline std::pair<T, T> basic_triangle_t<T>::projection (char axis, const basic_triangle_t& other) const
+{
+    std::array<T, 3> distances = distances_to_plane (other);
+    if (axis == 'x')
+        return projection<0> (distances);
+    if (axis == 'y')
+        return projection<1> (distances);
+    return projection<2> (distances);
+}
+
+// distances are the signed distances from a_, b_, c_ to the plane of the other triangle
+template <typename T>
+template <int axis>
+std::pair<T, T> basic_triangle_t<T>::projection (const std::array<T, 3>& distances) const
 {
-    // point_1 and point_2 lie on the same side of tr_2 and that point_mid lies on
-    // the other side
-    point_t point_1   = a_;
-    point_t point_mid = b_;
-    point_t point_2   = c_;
+    T project_a = a_.template get<axis> ();
+    T project_b = b_.template get<axis> ();
+    T project_c = c_.template get<axis> ();
 
-    // choose which axis to project on
-    double project_point_1   = point_1.z_;
-    double project_point_mid = point_mid.z_;
-    double project_point_2   = point_2.z_;
+    T distance_a = distances[0];
+    T distance_b = distances[1];
+    T distance_c = distances[2];
 
-    if (axis == 'x')
+    bool lie_a = (std::fabs (distance_a) < EPSILON);
+    bool lie_b = (std::fabs (distance_b) < EPSILON);
+    bool lie_c = (std::fabs (distance_c) < EPSILON);
+
+    // if two points lie on a plane tr_2
+    if (lie_a && lie_b)
+        return { project_a, project_b };
+    if (lie_b && lie_c)
+        return { project_c, project_b };
+    if (lie_a && lie_c)
+        return { project_a, project_c };
+
+    // point_1 and point_2 lie on the same side of tr_2 and point_mid lies on the
+    // other side. By default, the middle point is b_, it is swapped with a_ or c_
+    // if b_ shares a side with one of them, or with a_ if b_ lies in the plane.
+    bool swap_a = (distance_b * distance_c > 0);
+    bool swap_c = (!swap_a && distance_a * distance_b > 0);
+
+    T project_1   = swap_a ? project_b : project_a;
+    T distance_1  = swap_a ? distance_b : distance_a;
+    T project_2   = swap_c ? project_b : project_c;
+    T distance_2  = swap_c ? distance_b : distance_c;
+    T project_mid = swap_a ? project_a : (swap_c ? project_c : project_b);
+    T distance_mid = swap_a ? distance_a : (swap_c ? distance_c : distance_b);
+
+    bool swap_mid = (lie_b && distance_a * distance_c < 0);
+    T project_tmp  = project_1;
+    T distance_tmp = distance_1;
+    project_1    = swap_mid ? project_mid : project_1;
+    distance_1   = swap_mid ? distance_mid : distance_1;
+    project_mid  = swap_mid ? project_tmp : project_mid;
+    distance_mid = swap_mid ? distance_tmp : distance_mid;
+
+    // counting projections on the selected axis
+    T t1 = project_1 + (project_mid - project_1) * (distance_1 / (distance_1 - distance_mid));
+    T t2 = project_2 + (project_mid - project_2) * (distance_2 / (distance_2 - distance_mid));
+
+    return { t1, t2 };
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------ROBUST_KERNEL---------------------------------------
+
+// The predicates take doubles: the signs are exact for float and double coordinates,
+// long double ones are rounded to double first.
+
+// orientations of the vertices of other to the plane of the triangle
+template <typename T>
+inline void basic_triangle_t<T>::plane_sides (const basic_triangle_t& other, int& side_a, int& side_b, int& side_c) const
+{
+    predicates::orient3d_plane_t plane (a_.x_, a_.y_, a_.z_, b_.x_, b_.y_, b_.z_, c_.x_, c_.y_, c_.z_);
+
+    double det_a = plane (other.a_.x_, other.a_.y_, other.a_.z_);
+    double det_b = plane (other.b_.x_, other.b_.y_, other.b_.z_);
+    double det_c = plane (other.c_.x_, other.c_.y_, other.c_.z_);
+
+    side_a = (det_a > 0) - (det_a < 0);
+    side_b = (det_b > 0) - (det_b < 0);
+    side_c = (det_c > 0) - (det_c < 0);
+}
+
+// -1, 0 or 1, the sign of ((b - a) x (c - a), d - a)
+template <typename T>
+inline int basic_triangle_t<T>::orientation (const point_t& a, const point_t& b, const point_t& c, const point_t& d)
+{
+    double det = predicates::orient3d (a.x_, a.y_, a.z_, b.x_, b.y_, b.z_,
+                                       c.x_, c.y_, c.z_, d.x_, d.y_, d.z_);
+    return (det > 0) - (det < 0);
+}
+
+// orient2d of the projection along drop_axis, its sign is exact
+template <typename T>
+inline double basic_triangle_t<T>::orientation_2d (const point_t& a, const point_t& b, const point_t& c, int drop_axis)
+{
+    if (drop_axis == 0)
+        return predicates::orient2d (a.y_, a.z_, b.y_, b.z_, c.y_, c.z_);
+    if (drop_axis == 1)
+        return predicates::orient2d (a.z_, a.x_, b.z_, b.x_, c.z_, c.x_);
+    return predicates::orient2d (a.x_, a.y_, b.x_, b.y_, c.x_, c.y_);
+}
+
+// the components of (b - a) x (c - a) are the three projected orientations
+template <typename T>
+inline bool basic_triangle_t<T>::collinear (const point_t& a, const point_t& b, const point_t& c)
+{
+    return (orientation_2d (a, b, c, 0) == 0 && orientation_2d (a, b, c, 1) == 0 &&
+            orientation_2d (a, b, c, 2) == 0);
+}
+
+// the axis along which a, b, c (not collinear) project to the largest triangle,
+// the projection keeps every orientation in their plane
+template <typename T>
+inline int basic_triangle_t<T>::projection_axis (const point_t& a, const point_t& b, const point_t& c)
+{
+    double area_x = std::fabs (orientation_2d (a, b, c, 0));
+    double area_y = std::fabs (orientation_2d (a, b, c, 1));
+    double area_z = std::fabs (orientation_2d (a, b, c, 2));
+
+    if (area_x >= area_y && area_x >= area_z)
+        return 0;
+    return (area_y >= area_z) ? 1 : 2;
+}
+
+template <typename T>
+inline bool basic_triangle_t<T>::same_point (const point_t& p1, const point_t& p2)
+{
+    return (p1.x_ == p2.x_ && p1.y_ == p2.y_ && p1.z_ == p2.z_);
+}
+
+template <typename T>
+inline bool basic_triangle_t<T>::check_line_point_robust (const point_t& line_p1, const point_t& line_p2, 
+                                                 const point_t& p)
+{
+    if (!collinear (line_p1, line_p2, p))
+        return false;
+
+    // on the line the box of the segment is the segment
+    return (std::min (line_p1.x_, line_p2.x_) <= p.x_ && p.x_ <= std::max (line_p1.x_, line_p2.x_) &&
+            std::min (line_p1.y_, line_p2.y_) <= p.y_ && p.y_ <= std::max (line_p1.y_, line_p2.y_) &&
+            std::min (line_p1.z_, line_p2.z_) <= p.z_ && p.z_ <= std::max (line_p1.z_, line_p2.z_));
+}
+
+// both segments have distinct ends
+template <typename T>
+inline bool basic_triangle_t<T>::check_line_line_robust (const point_t& line1_p1, const point_t& line1_p2,
+                                                const point_t& line2_p1, const point_t& line2_p2)
+{
+    if (orientation (line1_p1, line1_p2, line2_p1, line2_p2) != 0)
+        return false;
+
+    bool collinear_1 = collinear (line1_p1, line1_p2, line2_p1);
+    bool collinear_2 = collinear (line1_p1, line1_p2, line2_p2);
+
+    // one line: the segments overlap iff their boxes do
+    if (collinear_1 && collinear_2)
     {
-        project_point_1   = point_1.x_;
-        project_point_mid = point_mid.x_;
-        project_point_2   = point_2.x_;
+        return (std::max (std::min (line1_p1.x_, line1_p2.x_), std::min (line2_p1.x_, line2_p2.x_)) <=
+                std::min (std::max (line1_p1.x_, line1_p2.x_), std::max (line2_p1.x_, line2_p2.x_)) &&
+                std::max (std::min (line1_p1.y_, line1_p2.y_), std::min (line2_p1.y_, line2_p2.y_)) <=
+                std::min (std::max (line1_p1.y_, line1_p2.y_), std::max (line2_p1.y_, line2_p2.y_)) &&
+                std::max (std::min (line1_p1.z_, line1_p2.z_), std::min (line2_p1.z_, line2_p2.z_)) <=
+                std::min (std::max (line1_p1.z_, line1_p2.z_), std::max (line2_p1.z_, line2_p2.z_)));
     }
-    else if (axis == 'y')
+
+    int axis = collinear_1 ? projection_axis (line1_p1, line1_p2, line2_p2) :
+                             projection_axis (line1_p1, line1_p2, line2_p1);
+
+    double o1 = orientation_2d (line1_p1, line1_p2, line2_p1, axis);
+    double o2 = orientation_2d (line1_p1, line1_p2, line2_p2, axis);
+    double o3 = orientation_2d (line2_p1, line2_p2, line1_p1, axis);
+    double o4 = orientation_2d (line2_p1, line2_p2, line1_p2, axis);
+
+    if (((o1 > 0 && o2 < 0) || (o1 < 0 && o2 > 0)) &&
+        ((o3 > 0 && o4 < 0) || (o3 < 0 && o4 > 0)))
+        return true;
+
+    return ((o1 == 0 && check_line_point_robust (line1_p1, line1_p2, line2_p1)) ||
+            (o2 == 0 && check_line_point_robust (line1_p1, line1_p2, line2_p2)) ||
+            (o3 == 0 && check_line_point_robust (line2_p1, line2_p2, line1_p1)) ||
+            (o4 == 0 && check_line_point_robust (line2_p1, line2_p2, line1_p2)));
+}
+
+// the ends of collinear points are the least and the greatest in lexicographic order
+template <typename T>
+inline std::pair<const basic_point_t<T>*, const basic_point_t<T>*> basic_triangle_t<T>::select_ends_segment_robust (const point_t& p1, 
+                              const point_t& p2, const point_t& p3)
+{
+    auto less = [] (const point_t* lhs, const point_t* rhs)
     {
-        project_point_1   = point_1.y_;
-        project_point_mid = point_mid.y_;
-        project_point_2   = point_2.y_;
+        if (lhs->x_ != rhs->x_)
+            return lhs->x_ < rhs->x_;
+        if (lhs->y_ != rhs->y_)
+            return lhs->y_ < rhs->y_;
+        return lhs->z_ < rhs->z_;
+    };
+
+    const point_t* points[] = { &p1, &p2, &p3 };
+    auto ends = std::minmax_element (std::begin (points), std::end (points), less);
+    return { *ends.first, *ends.second };
+}
+
+template <typename T>
+inline bool basic_triangle_t<T>::check_triangle_point_robust (const point_t& p) const
+{
+    if (orientation (a_, b_, c_, p) != 0)
+        return false;
+
+    int axis = projection_axis (a_, b_, c_);
+    double side = orientation_2d (a_, b_, c_, axis);
+
+    double res_1 = orientation_2d (a_, b_, p, axis);
+    double res_2 = orientation_2d (b_, c_, p, axis);
+    double res_3 = orientation_2d (c_, a_, p, axis);
+
+    if (side < 0)
+        return (res_1 <= 0 && res_2 <= 0 && res_3 <= 0);
+    return (res_1 >= 0 && res_2 >= 0 && res_3 >= 0);
+}
+
+template <typename T>
+inline bool basic_triangle_t<T>::check_triangle_line_robust (const point_t& p1, const point_t& p2,
+                                                    int side_1, int side_2) const
+{
+    if (side_1 * side_2 > 0)
+        return false;
+
+    // lies in the plane
+    if (side_1 == 0 && side_2 == 0)
+    {
+        return (check_triangle_point_robust (p1) || check_triangle_point_robust (p2) ||
+                check_line_line_robust (p1, p2, a_, b_) ||
+                check_line_line_robust (p1, p2, b_, c_) ||
+                check_line_line_robust (p1, p2, c_, a_));
     }
 
-    // if two points lie on a plane tr_2
-    if (other.point_lie_in_plane_tr (a_) && 
-        other.point_lie_in_plane_tr (b_))
+    // touches the plane by one end
+    if (side_1 == 0)
+        return check_triangle_point_robust (p1);
+    if (side_2 == 0)
+        return check_triangle_point_robust (p2);
+
+    // crosses the plane: the line passes every edge on the same side
+    int o1 = orientation (p1, p2, a_, b_);
+    int o2 = orientation (p1, p2, b_, c_);
+    int o3 = orientation (p1, p2, c_, a_);
+
+    return ((o1 >= 0 && o2 >= 0 && o3 >= 0) || (o1 <= 0 && o2 <= 0 && o3 <= 0));
+}
+
+template <typename T>
+inline bool basic_triangle_t<T>::check_triangle_line_robust (const point_t& p1, const point_t& p2) const
+{
+    return check_triangle_line_robust (p1, p2, orientation (a_, b_, c_, p1), orientation (a_, b_, c_, p2));
+}
+
+// both triangles are not degenerate and lie in one plane
+template <typename T>
+inline bool basic_triangle_t<T>::check_coplanar_robust (const basic_triangle_t& other) const
+{
+    return (check_triangle_line_robust (other.a_, other.b_, 0, 0) ||
+            check_triangle_line_robust (other.b_, other.c_, 0, 0) ||
+            check_triangle_line_robust (other.c_, other.a_, 0, 0) ||
+            other.check_triangle_point_robust (a_));
+}
+
+// The same case analysis as the epsilon kernel. Two triangles in general position
+// intersect iff an edge of one of them meets the other one: the ends of the
+// common segment lie on the edges.
+template <typename T>
+inline bool basic_triangle_t<T>::check_intersection_robust (const basic_triangle_t& other) const
+{
+    bool is_point = robust_triangle_is_point ();
+    bool other_is_point = other.robust_triangle_is_point ();
+    if (is_point || other_is_point)
     {
-        return { project_point_1, project_point_mid };
+        const basic_triangle_t& point = is_point ? *this : other;
+        const basic_triangle_t& tr    = is_point ? other : *this;
+
+        if (is_point && other_is_point)
+        {
+            TRIANGLES_PROFILE_BRANCH (point_point);
+            return same_point (point.a_, tr.a_);
+        }
+
+        if (tr.robust_degenerate_tr ())
+        {
+            TRIANGLES_PROFILE_BRANCH (line_point);
+            auto pair = select_ends_segment_robust (tr.a_, tr.b_, tr.c_);
+            return check_line_point_robust (*pair.first, *pair.second, point.a_);
+        }
+
+        TRIANGLES_PROFILE_BRANCH (triangle_point);
+        return tr.check_triangle_point_robust (point.a_);
     }
 
-    if (other.point_lie_in_plane_tr (b_) && 
-        other.point_lie_in_plane_tr (c_))
+    bool degenerate = robust_degenerate_tr ();
+    bool other_degenerate = other.robust_degenerate_tr ();
+    if (degenerate || other_degenerate)
     {
-        return { project_point_2, project_point_mid };
+        const basic_triangle_t& line = degenerate ? *this : other;
+        const basic_triangle_t& tr   = degenerate ? other : *this;
+        auto pair = select_ends_segment_robust (line.a_, line.b_, line.c_);
+
+        if (degenerate && other_degenerate)
+        {
+            TRIANGLES_PROFILE_BRANCH (line_line);
+            auto pair_tr = select_ends_segment_robust (tr.a_, tr.b_, tr.c_);
+            return check_line_line_robust (*pair.first, *pair.second, *pair_tr.first, *pair_tr.second);
+        }
+
+        TRIANGLES_PROFILE_BRANCH (triangle_line);
+        return tr.check_triangle_line_robust (*pair.first, *pair.second);
     }
-    if (other.point_lie_in_plane_tr (a_) && 
-        other.point_lie_in_plane_tr (c_))
+
+    // sides of the vertices of other to the plane of this and back
+    int side_a = 0, side_b = 0, side_c = 0;
+    plane_sides (other, side_a, side_b, side_c);
+    if ((side_a > 0 && side_b > 0 && side_c > 0) || (side_a < 0 && side_b < 0 && side_c < 0))
     {
-        return { project_point_1, project_point_2 };
+        TRIANGLES_PROFILE_BRANCH (same_sign_rejection);
+        return false;
     }
 
-    // By default, the middle point is point B, below are 3 cases where point B cannot be middle
+    int other_side_a = 0, other_side_b = 0, other_side_c = 0;
+    other.plane_sides (*this, other_side_a, other_side_b, other_side_c);
+    if ((other_side_a > 0 && other_side_b > 0 && other_side_c > 0) ||
+        (other_side_a < 0 && other_side_b < 0 && other_side_c < 0))
+    {
+        TRIANGLES_PROFILE_BRANCH (same_sign_rejection);
+        return false;
+    }
 
-    if (other.distance_point_plane_tr (b_) * 
-        other.distance_point_plane_tr (c_) > 0)
+    if (side_a == 0 && side_b == 0 && side_c == 0)
     {
-        std::swap (project_point_1, project_point_mid);
-        std::swap (point_1, point_mid);
+        TRIANGLES_PROFILE_BRANCH (coplanar);
+        return check_coplanar_robust (other);
     }
-    else if (other.distance_point_plane_tr (a_) * 
-             other.distance_point_plane_tr (b_) > 0)
+
+    TRIANGLES_PROFILE_BRANCH (general_position);
+    return (check_triangle_line_robust (other.a_, other.b_, side_a, side_b) ||
+            check_triangle_line_robust (other.b_, other.c_, side_b, side_c) ||
+            check_triangle_line_robust (other.c_, other.a_, side_c, side_a) ||
+            other.check_triangle_line_robust (a_, b_, other_side_a, other_side_b) ||
+            other.check_triangle_line_robust (b_, c_, other_side_b, other_side_c) ||
+            other.check_triangle_line_robust (c_, a_, other_side_c, other_side_a));
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------GUIGUE_DEVILLERS------------------------------------
+
+// P. Guigue, O. Devillers, "Fast and Robust Triangle-Triangle Overlap Test Using
+// Orientation Predicates". The vertices of both triangles are turned so that p1 and
+// p2 are alone on their sides of the other plane and the planes are oriented so
+// that the intersections of the triangles with the common line are the intervals
+// [i, j] and [k, l] in the same direction. They overlap iff k <= j and i <= l, that
+// is two orientations; nothing is divided and nothing is projected.
+
+template <typename T>
+inline bool basic_triangle_t<T>::check_intervals_overlap_gd (const point_t& p1, const point_t& q1, const point_t& r1,
+                                                    const point_t& p2, const point_t& q2, const point_t& r2)
+{
+    if (orientation (q1, p2, p1, q2) > 0)
+        return false;
+    return (orientation (p1, p2, r1, r2) <= 0);
+}
+
+// p1 is alone on its side of the plane of the second triangle, the second
+// triangle is turned the same way and the first one is flipped to keep the
+// orientation of the planes
+template <typename T>
+inline bool basic_triangle_t<T>::check_turned_gd (const point_t& p1, const point_t& q1, const point_t& r1,
+                                         const point_t& p2, const point_t& q2, const point_t& r2,
+                                         int side_p2, int side_q2, int side_r2)
+{
+    if (side_p2 > 0)
     {
-        std::swap (project_point_2, project_point_mid);
-        std::swap (point_2, point_mid);
+        if (side_q2 > 0)
+            return check_intervals_overlap_gd (p1, r1, q1, r2, p2, q2);
+        if (side_r2 > 0)
+            return check_intervals_overlap_gd (p1, r1, q1, q2, r2, p2);
+        return check_intervals_overlap_gd (p1, q1, r1, p2, q2, r2);
     }
 
-    if (other.point_lie_in_plane_tr (b_) && 
-        other.distance_point_plane_tr (a_) * 
-        other.distance_point_plane_tr (c_) < 0)
+    if (side_p2 < 0)
     {
-        std::swap (project_point_1, project_point_mid);
-        std::swap (point_1, point_mid);
+        if (side_q2 < 0)
+            return check_intervals_overlap_gd (p1, q1, r1, r2, p2, q2);
+        if (side_r2 < 0)
+            return check_intervals_overlap_gd (p1, q1, r1, q2, r2, p2);
+        return check_intervals_overlap_gd (p1, r1, q1, p2, q2, r2);
     }
 
-    // counting projections on the selected axis
-    double t1 = project_point_1 + 
-                (project_point_mid - project_point_1) * (other.distance_point_plane_tr (point_1) / 
-                (other.distance_point_plane_tr (point_1) - other.distance_point_plane_tr (point_mid)));
+    if (side_q2 < 0)
+    {
+        if (side_r2 >= 0)
+            return check_intervals_overlap_gd (p1, r1, q1, q2, r2, p2);
+        return check_intervals_overlap_gd (p1, q1, r1, p2, q2, r2);
+    }
 
-    double t2 = project_point_2 + 
-                (project_point_mid - project_point_2) * (other.distance_point_plane_tr (point_2) / 
-                (other.distance_point_plane_tr (point_2) - other.distance_point_plane_tr (point_mid)));
+    if (side_q2 > 0)
+    {
+        if (side_r2 > 0)
+            return check_intervals_overlap_gd (p1, r1, q1, p2, q2, r2);
+        return check_intervals_overlap_gd (p1, q1, r1, q2, r2, p2);
+    }
 
-    return { t1, t2 };
+    // side_r2 is not 0, coplanar triangles do not get here
+    if (side_r2 > 0)
+        return check_intervals_overlap_gd (p1, q1, r1, r2, p2, q2);
+    return check_intervals_overlap_gd (p1, r1, q1, r2, p2, q2);
+}
+
+// Degenerate and coplanar pairs are left to the robust kernel, so both kernels
+// give the same answers.
+template <typename T>
+inline bool basic_triangle_t<T>::check_intersection_guigue_devillers (const basic_triangle_t& other) const
+{
+    if (robust_degenerate_tr () || other.robust_degenerate_tr ())
+        return check_intersection_robust (other);
+
+    // sides of the vertices of other to the plane of this and back
+    int side_p2 = 0, side_q2 = 0, side_r2 = 0;
+    plane_sides (other, side_p2, side_q2, side_r2);
+    if ((side_p2 > 0 && side_q2 > 0 && side_r2 > 0) || (side_p2 < 0 && side_q2 < 0 && side_r2 < 0))
+    {
+        TRIANGLES_PROFILE_BRANCH (same_sign_rejection);
+        return false;
+    }
+
+    int side_p1 = 0, side_q1 = 0, side_r1 = 0;
+    other.plane_sides (*this, side_p1, side_q1, side_r1);
+    if ((side_p1 > 0 && side_q1 > 0 && side_r1 > 0) || (side_p1 < 0 && side_q1 < 0 && side_r1 < 0))
+    {
+        TRIANGLES_PROFILE_BRANCH (same_sign_rejection);
+        return false;
+    }
+
+    if (side_p2 == 0 && side_q2 == 0 && side_r2 == 0)
+    {
+        TRIANGLES_PROFILE_BRANCH (coplanar);
+        return check_coplanar_robust (other);
+    }
+
+    TRIANGLES_PROFILE_BRANCH (general_position);
+    const point_t& p1 = a_;
+    const point_t& q1 = b_;
+    const point_t& r1 = c_;
+    const point_t& p2 = other.a_;
+    const point_t& q2 = other.b_;
+    const point_t& r2 = other.c_;
+
+    // turn this so that p1 is alone on its side, the second triangle is flipped
+    // when p1 is on the negative side
+    if (side_p1 > 0)
+    {
+        if (side_q1 > 0)
+            return check_turned_gd (r1, p1, q1, p2, r2, q2, side_p2, side_r2, side_q2);
+        if (side_r1 > 0)
+            return check_turned_gd (q1, r1, p1, p2, r2, q2, side_p2, side_r2, side_q2);
+        return check_turned_gd (p1, q1, r1, p2, q2, r2, side_p2, side_q2, side_r2);
+    }
+
+    if (side_p1 < 0)
+    {
+        if (side_q1 < 0)
+            return check_turned_gd (r1, p1, q1, p2, q2, r2, side_p2, side_q2, side_r2);
+        if (side_r1 < 0)
+            return check_turned_gd (q1, r1, p1, p2, q2, r2, side_p2, side_q2, side_r2);
+        return check_turned_gd (p1, q1, r1, p2, r2, q2, side_p2, side_r2, side_q2);
+    }
+
+    if (side_q1 < 0)
+    {
+        if (side_r1 >= 0)
+            return check_turned_gd (q1, r1, p1, p2, r2, q2, side_p2, side_r2, side_q2);
+        return check_turned_gd (p1, q1, r1, p2, q2, r2, side_p2, side_q2, side_r2);
+    }
+
+    if (side_q1 > 0)
+    {
+        if (side_r1 > 0)
+            return check_turned_gd (p1, q1, r1, p2, r2, q2, side_p2, side_r2, side_q2);
+        return check_turned_gd (q1, r1, p1, p2, q2, r2, side_p2, side_q2, side_r2);
+    }
+
+    if (side_r1 > 0)
+        return check_turned_gd (r1, p1, q1, p2, q2, r2, side_p2, side_q2, side_r2);
+    return check_turned_gd (r1, p1, q1, p2, r2, q2, side_p2, side_r2, side_q2);
 }
 
 // ----------------------------------------------------------------------------------
 
 // ------------------------------OTHER_FUNC------------------------------------------
 
-std::istream& operator>> (std::istream& in, point_t& p);
+// coords holds 9 numbers (a, b, c) per triangle. The triangles are constructed in
+// place, blocks of BUILD_BLOCK_SIZE run on pool.
+template <typename T>
+std::vector<basic_triangle_t<T>> build_triangles (const std::vector<T>& coords, thread_pool_t& pool)
+{
+    std::size_t num = coords.size () / 9;
+    std::vector<basic_triangle_t<T>> array_triangle (num);
+
+    std::size_t num_blocks = (num + BUILD_BLOCK_SIZE - 1) / BUILD_BLOCK_SIZE;
+    pool.parallel_for (0, num_blocks, [&] (std::size_t block)
+    {
+        std::size_t end = std::min ((block + 1) * BUILD_BLOCK_SIZE, num);
+        for (std::size_t i = block * BUILD_BLOCK_SIZE; i < end; ++i)
+        {
+            const T* v = coords.data () + 9 * i;
+            array_triangle[i] = basic_triangle_t<T> ({ v[0], v[1], v[2] }, { v[3], v[4], v[5] },
+                                                     { v[6], v[7], v[8] });
+        }
+    });
+
+    return array_triangle;
+}
 
-std::istream& operator>> (std::istream& in, point_t& p)
+template <typename T>
+std::istream& operator>> (std::istream& in, basic_point_t<T>& p)
 {
     in >> p.x_ >> p.y_ >> p.z_;
     return in;
@@ -502,4 +1388,24 @@ std::istream& operator>> (std::istream& in, point_t& p)
 
 // ----------------------------------------------------------------------------------
 
+// ------------------------------SCALAR_TYPES----------------------------------------
+
+// double is the scalar of the program, float and long double are instantiated in
+// src/triangles.cpp as well
+using point_t    = basic_point_t<double>;
+using vector_t   = basic_vector_t<double>;
+using ray_t      = basic_ray_t<double>;
+using triangle_t = basic_triangle_t<double>;
+
+static_assert (std::is_trivially_copyable<point_t>::value, "point_t is copied as raw memory");
+static_assert (std::is_trivially_copyable<vector_t>::value, "vector_t is copied as raw memory");
+static_assert (std::is_trivially_copyable<triangle_t>::value, "triangle_t is copied as raw memory");
+static_assert (std::is_trivially_copyable<basic_triangle_t<float>>::value, "triangle_t is copied as raw memory");
+
+extern template class basic_triangle_t<float>;
+extern template class basic_triangle_t<double>;
+extern template class basic_triangle_t<long double>;
+
+// ----------------------------------------------------------------------------------
+
 #endif // TRIANGLES_HPP
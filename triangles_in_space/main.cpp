@@ -1,29 +1,436 @@
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <set>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "triangles.hpp"
 #include "octree.hpp"
+#include "batch.hpp"
+#include "engine.hpp"
+#include "out_of_core.hpp"
+#include "output.hpp"
+#include "numa.hpp"
+#include "reorder.hpp"
+#include "server.hpp"
 
-int main ()
+struct options_t
+{
+    kernel_t kernel = DEFAULT_KERNEL;
+    engine_t engine = engine_t::automatic;
+    engine_calibration_t calibration {};
+    std::string calibrate_path {};
+    std::string scalar = "double";
+    output_format_t format = output_format_t::text;
+    bool print_stats = false;
+    bool reorder = false;
+    bool gather = false;
+    bool numa = false;
+    std::size_t numa_nodes = 0; // 0 is the detected topology
+    std::string out_of_core_directory {};
+    std::size_t memory_budget_mb = OUT_OF_CORE_DEFAULT_BUDGET_MB;
+    bool batch = false;
+    bool server_mode = false;
+    std::string socket_path {};
+};
+
+// N and the 9 * N coordinates of the triangles
+template <typename T>
+static std::vector<T> read_coords (std::istream& in)
 {
     std::size_t N = 0;
-    std::cin >> N;
-    std::vector<triangle_t> array_triangle;
+    in >> N;
+    std::vector<T> coords (9 * N);
+
+    for (auto& tmp : coords)
+    {
+        in >> tmp;
+    }
+    return coords;
+}
+
+static int write_output (const std::vector<char>& buffer)
+{
+    if (!write_buffer (stdout, buffer))
+    {
+        std::cerr << "cannot write the output\n";
+        return 1;
+    }
+    return 0;
+}
+
+static int write_flags (const std::vector<unsigned char>& flags, output_format_t format)
+{
+    std::vector<char> buffer {};
+    if (!format_intersections (flags, format, buffer))
+    {
+        std::cerr << "the numbers of the triangles do not fit into " << output_format_name (format) << "\n";
+        return 1;
+    }
+    return write_output (buffer);
+}
+
+// reads the triangles from stdin and prints the numbers of the intersecting ones
+template <typename T>
+static int run (const options_t& options)
+{
+    std::vector<T> coords = read_coords<T> (std::cin);
+
+    if (options.numa)
+    {
+        numa_topology_t topology = (options.numa_nodes > 0) ? simulated_numa_topology (options.numa_nodes)
+                                                            : detect_numa_topology ();
+        numa_pool_t numa_pool (topology);
+        std::vector<octree_stats_t> node_stats {};
+        std::vector<unsigned char> flags = get_numa_intersection_flags (coords, numa_pool, options.kernel,
+                                                                        options.gather, &node_stats);
+        if (write_flags (flags, options.format) != 0)
+            return 1;
+
+        if (options.print_stats)
+        {
+            std::cerr << "numa nodes:           " << numa_pool.get_num_nodes () << "\n";
+            for (std::size_t node = 0; node < node_stats.size (); ++node)
+                std::cerr << "node " << node << ":\n" << node_stats[node];
+        }
+        return 0;
+    }
+
+    thread_pool_t pool {};
+    std::vector<basic_triangle_t<T>> array_triangle = build_triangles (coords, pool);
+
+    if (select_engine (options.engine, array_triangle.size (), options.calibration) == engine_t::naive)
+    {
+        if (options.print_stats)
+            std::cerr << "engine:               naive\n";
+        return write_flags (get_intersection_flags_naive (array_triangle, options.kernel), options.format);
+    }
+
+    std::vector<std::size_t> order {};
+    if (options.reorder)
+        order = reorder_morton (array_triangle, pool);
+
+    basic_octree_t<T> tree(array_triangle, pool);
+    tree.set_kernel (options.kernel);
+    tree.set_gather_leaves (options.gather);
+    std::vector<unsigned char> flags = tree.get_intersection_flags (pool);
+    if (options.reorder)
+        flags = restore_order (flags, order);
+
+    if (write_flags (flags, options.format) != 0)
+        return 1;
+
+    if (options.print_stats)
+    {
+        std::cerr << tree.get_stats ();
+#ifdef TRIANGLES_PROFILE
+        branch_profile_t::instance ().print (std::cerr);
+#endif
+    }
+    return 0;
+}
+
+// reads the number of scenes and the scenes, each one as the input of run, and
+// prints the result of every scene after its header (output.hpp)
+template <typename T>
+static int run_batch (const options_t& options)
+{
+    std::size_t num_scenes = 0;
+    std::cin >> num_scenes;
+
+    thread_pool_t pool {};
+    std::vector<std::vector<basic_triangle_t<T>>> scenes (num_scenes);
+    for (auto& scene : scenes)
+        scene = build_triangles (read_coords<T> (std::cin), pool);
+
+    std::vector<std::vector<unsigned char>> flags = get_batch_intersection_flags (scenes, pool, options.kernel,
+                                                                                       options.engine, options.calibration);
+
+    std::vector<char> buffer {};
+    for (const auto& scene_flags : flags)
+    {
+        format_batch_header (scene_flags, options.format, buffer);
+        if (!format_intersections (scene_flags, options.format, buffer))
+        {
+            std::cerr << "the numbers of the triangles do not fit into " << output_format_name (options.format) << "\n";
+            return 1;
+        }
+    }
+    return write_output (buffer);
+}
+
+// answers the requests of server.hpp from stdin, or from the connections to the unix
+// socket socket_path if it is not empty; the pool and the trees stay alive between them
+template <typename T>
+static int serve (const options_t& options)
+{
+    std::ios::sync_with_stdio (false);
+    thread_pool_t pool {};
+    basic_server_t<T> server (pool, options.kernel);
+
+    if (options.socket_path.empty ())
+    {
+        server.serve (std::cin, std::cout);
+        return 0;
+    }
+
+    auto serve_connection = [&] (std::istream& in, std::ostream& out) { return server.serve (in, out); };
+    if (!serve_unix_socket (options.socket_path, serve_connection))
+    {
+        std::cerr << "cannot listen on " << options.socket_path << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// reads the triangles from stdin through the files of out_of_core_directory and prints
+// the numbers of the intersecting ones; the memory is bounded by memory_budget_mb
+template <typename T>
+static int run_out_of_core (const options_t& options)
+{
+    thread_pool_t pool {};
+    basic_out_of_core_t<T> out_of_core (options.out_of_core_directory, options.memory_budget_mb << 20, pool,
+                                        options.kernel);
+    if (!out_of_core.run (std::cin, stdout, options.format))
+    {
+        if (std::cin.fail ())
+            std::cerr << "cannot read the triangles\n";
+        else
+            std::cerr << "cannot verify the triangles through " << options.out_of_core_directory << "\n";
+        return 1;
+    }
 
-    for (std::size_t i = 0; i < N; ++i)
+    if (options.print_stats)
+        std::cerr << out_of_core.get_stats ();
+    return 0;
+}
+
+// measures the crossover of the engines, saves it to path and prints it
+template <typename T>
+static int calibrate (const options_t& options)
+{
+    engine_calibration_t calibration = calibrate_engine<T> (options.kernel);
+    if (!save_calibration (options.calibrate_path, calibration))
     {
-        point_t p1, p2, p3;
-        std::cin >> p1 >> p2 >> p3;
-        array_triangle.push_back ({ p1, p2, p3 });
+        std::cerr << "cannot write " << options.calibrate_path << "\n";
+        return 1;
     }
 
-    octree_t tree(array_triangle);
-    std::set<std::size_t> triangle_num = tree.get_num_tr_intersection ();
-    
-    for (auto tmp: triangle_num)
+    std::cout << "naive_max_triangles " << calibration.naive_max_triangles_ << "\n";
+    return 0;
+}
+
+// the option that selects the mode of option, empty for the options of no mode
+static std::string mode_of_option (const std::string& option)
+{
+    if (option == "--socket")
+        return "--serve";
+    if (option == "--numa-nodes")
+        return "--numa";
+    if (option == "--calibrate" || option == "--serve" || option == "--batch" || option == "--out-of-core" ||
+        option == "--numa")
+        return option;
+    return "";
+}
+
+// the options followed by a value
+static const std::vector<std::string> VALUE_OPTIONS { "--kernel", "--scalar", "--output", "--engine", "--calibration",
+                                                      "--calibrate", "--numa-nodes", "--out-of-core",
+                                                      "--memory-budget", "--socket" };
+
+// the options of every mode
+static const std::vector<std::string> COMMON_OPTIONS { "--kernel", "--robust", "--scalar" };
+
+// the other options a mode takes, the empty mode is run
+static const std::vector<std::pair<std::string, std::vector<std::string>>> MODE_OPTIONS
+{
+    { "",              { "--stats", "--output", "--engine", "--calibration", "--reorder", "--gather" } },
+    { "--numa",        { "--stats", "--output", "--gather" } },
+    { "--out-of-core", { "--stats", "--output", "--memory-budget" } },
+    { "--batch",       { "--output", "--engine", "--calibration" } },
+    { "--serve",       {} },
+    { "--calibrate",   {} }
+};
+
+static bool takes_option (const std::string& mode, const std::string& option)
+{
+    if (std::find (COMMON_OPTIONS.begin (), COMMON_OPTIONS.end (), option) != COMMON_OPTIONS.end ())
+        return true;
+
+    for (const auto& mode_options : MODE_OPTIONS)
+    {
+        if (mode_options.first == mode)
+            return std::find (mode_options.second.begin (), mode_options.second.end (), option) !=
+                   mode_options.second.end ();
+    }
+    return false;
+}
+
+// false with a message if the options select two modes or one the mode does not take
+static bool check_options (const std::vector<std::string>& given)
+{
+    std::string mode {};
+    for (const auto& option : given)
+    {
+        std::string option_mode = mode_of_option (option);
+        if (!option_mode.empty () && !mode.empty () && option_mode != mode)
+        {
+            std::cerr << option << " cannot be used with " << mode << "\n";
+            return false;
+        }
+        if (!option_mode.empty ())
+            mode = option_mode;
+    }
+
+    for (const auto& option : given)
+    {
+        if (!mode_of_option (option).empty () || takes_option (mode, option))
+            continue;
+
+        if (!mode.empty ())
+            std::cerr << option << " cannot be used with " << mode << "\n";
+        else
+        {
+            std::cerr << option << " needs";
+            for (const auto& mode_options : MODE_OPTIONS)
+            {
+                if (!mode_options.first.empty () && takes_option (mode_options.first, option))
+                    std::cerr << " " << mode_options.first;
+            }
+            std::cerr << "\n";
+        }
+        return false;
+    }
+    return true;
+}
+
+template <typename T>
+static int run_mode (const options_t& options)
+{
+    if (!options.calibrate_path.empty ())
+        return calibrate<T> (options);
+    if (options.server_mode)
+        return serve<T> (options);
+    if (options.batch)
+        return run_batch<T> (options);
+    if (!options.out_of_core_directory.empty ())
+        return run_out_of_core<T> (options);
+
+    return run<T> (options);
+}
+
+// --stats prints the octree statistics to stderr,
+// --kernel NAME selects the kernel of check_intersection (epsilon, robust,
+// guigue_devillers), --robust is --kernel robust,
+// --scalar float|double|long_double is the type of the coordinates,
+// --serve answers the requests of server.hpp from stdin, --socket PATH from a unix socket,
+// --output text|uint32|bitmap is the format of the result (output.hpp),
+// --batch reads many scenes (run_batch),
+// --engine octree|naive|auto is the algorithm (engine.hpp), auto by default,
+// --calibration FILE reads the crossover of auto, --calibrate FILE measures and saves it,
+// --reorder renumbers the triangles along the Morton curve before building the tree,
+// --gather checks the pairs of a leaf on its copy (basic_leaf_buffer_t),
+// --numa verifies a slab of the space on every numa node (numa.hpp), --numa-nodes N
+// on N simulated nodes,
+// --out-of-core DIR keeps the triangles in the files of DIR (out_of_core.hpp) and
+// --memory-budget MB bounds the memory, OUT_OF_CORE_DEFAULT_BUDGET_MB by default;
+// an unknown option or one the mode does not take (MODE_OPTIONS) is an error
+int main (int argc, char* argv[])
+{
+    options_t options {};
+    std::vector<std::string> given {};
+    for (int i = 1; i < argc; ++i)
+    {
+        given.push_back (argv[i]);
+        if (std::strcmp (argv[i], "--stats") == 0)
+            options.print_stats = true;
+        else if (std::strcmp (argv[i], "--robust") == 0)
+            options.kernel = kernel_t::robust;
+        else if (std::strcmp (argv[i], "--kernel") == 0 && i + 1 < argc)
+        {
+            if (!kernel_from_name (argv[++i], options.kernel))
+            {
+                std::cerr << "unknown kernel " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if (std::strcmp (argv[i], "--scalar") == 0 && i + 1 < argc)
+            options.scalar = argv[++i];
+        else if (std::strcmp (argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            if (!output_format_from_name (argv[++i], options.format))
+            {
+                std::cerr << "unknown output format " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if (std::strcmp (argv[i], "--engine") == 0 && i + 1 < argc)
+        {
+            if (!engine_from_name (argv[++i], options.engine))
+            {
+                std::cerr << "unknown engine " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if (std::strcmp (argv[i], "--calibration") == 0 && i + 1 < argc)
+        {
+            if (!load_calibration (argv[++i], options.calibration))
+            {
+                std::cerr << "cannot read the calibration " << argv[i] << "\n";
+                return 1;
+            }
+        }
+        else if (std::strcmp (argv[i], "--calibrate") == 0 && i + 1 < argc)
+            options.calibrate_path = argv[++i];
+        else if (std::strcmp (argv[i], "--reorder") == 0)
+            options.reorder = true;
+        else if (std::strcmp (argv[i], "--gather") == 0)
+            options.gather = true;
+        else if (std::strcmp (argv[i], "--numa") == 0)
+            options.numa = true;
+        else if (std::strcmp (argv[i], "--numa-nodes") == 0 && i + 1 < argc)
+        {
+            options.numa = true;
+            options.numa_nodes = std::strtoul (argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp (argv[i], "--out-of-core") == 0 && i + 1 < argc)
+            options.out_of_core_directory = argv[++i];
+        else if (std::strcmp (argv[i], "--memory-budget") == 0 && i + 1 < argc)
+            options.memory_budget_mb = std::strtoul (argv[++i], nullptr, 10);
+        else if (std::strcmp (argv[i], "--batch") == 0)
+            options.batch = true;
+        else if (std::strcmp (argv[i], "--serve") == 0)
+            options.server_mode = true;
+        else if (std::strcmp (argv[i], "--socket") == 0 && i + 1 < argc)
+        {
+            options.server_mode = true;
+            options.socket_path = argv[++i];
+        }
+        else
+        {
+            if (std::find (VALUE_OPTIONS.begin (), VALUE_OPTIONS.end (), given.back ()) != VALUE_OPTIONS.end ())
+                std::cerr << argv[i] << " needs a value\n";
+            else
+                std::cerr << "unknown option " << argv[i] << "\n";
+            return 1;
+        }
+    }
+
+    if (!check_options (given))
+        return 1;
+
+    if (options.scalar == "float")
+        return run_mode<float> (options);
+    else if (options.scalar == "double")
+        return run_mode<double> (options);
+    else if (options.scalar == "long_double")
+        return run_mode<long double> (options);
+    else
     {
-         std::cout << tmp << "\n";
+        std::cerr << "unknown scalar type " << options.scalar << "\n";
+        return 1;
     }
 }
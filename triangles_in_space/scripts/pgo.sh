@@ -0,0 +1,29 @@
+#!/bin/sh
+# Profile-guided build: an instrumented build runs the scenes of the scaling
+# benchmark through the main program, then the same build directory is rebuilt
+# with the collected profile. Run from the project directory.
+set -e
+
+N=${N:-100000}
+BUILD=build/pgo
+PROFILE=$BUILD/pgo-profile
+
+cmake --preset pgo-generate -DTRIANGLES_PGO_DIR="$PWD/$PROFILE"
+rm -rf "$PROFILE"
+cmake --build --preset pgo-generate -j"$(nproc)"
+
+for distribution in uniform clustered slivers coplanar degenerate far_away; do
+    for kernel in epsilon robust guigue_devillers; do
+        echo "training: $distribution, $kernel"
+        "$BUILD"/benchmarks/scaling --generate "$distribution" "$N" |
+            "$BUILD"/triangle_calculations --kernel "$kernel" > /dev/null
+    done
+done
+
+# clang writes raw profiles that must be merged
+if ls "$PROFILE"/*.profraw > /dev/null 2>&1; then
+    llvm-profdata merge -output="$PROFILE"/default.profdata "$PROFILE"/*.profraw
+fi
+
+cmake --preset pgo-use -DTRIANGLES_PGO_DIR="$PWD/$PROFILE"
+cmake --build --preset pgo-use -j"$(nproc)"
@@ -0,0 +1,50 @@
+#include "engine.hpp"
+
+#include <fstream>
+
+// ------------------------------ENGINE_T--------------------------------------------
+
+std::string engine_name (engine_t engine)
+{
+    switch (engine)
+    {
+        case engine_t::octree:    return "octree";
+        case engine_t::naive:     return "naive";
+        case engine_t::automatic: return "auto";
+    }
+    return "unknown";
+}
+
+bool engine_from_name (const std::string& name, engine_t& engine)
+{
+    for (auto tmp : ALL_ENGINES)
+    {
+        if (engine_name (tmp) == name)
+        {
+            engine = tmp;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool load_calibration (const std::string& path, engine_calibration_t& calibration)
+{
+    std::ifstream in (path);
+    std::string key;
+    std::size_t naive_max_triangles = 0;
+    if (!(in >> key >> naive_max_triangles) || key != "naive_max_triangles")
+        return false;
+
+    calibration.naive_max_triangles_ = naive_max_triangles;
+    return true;
+}
+
+bool save_calibration (const std::string& path, const engine_calibration_t& calibration)
+{
+    std::ofstream out (path);
+    out << "naive_max_triangles " << calibration.naive_max_triangles_ << "\n";
+    return static_cast<bool> (out);
+}
+
+// ----------------------------------------------------------------------------------
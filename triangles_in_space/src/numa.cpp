@@ -0,0 +1,122 @@
+#include "numa.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <dirent.h>
+#include <sched.h>
+
+// ------------------------------NUMA_TOPOLOGY_T-------------------------------------
+
+namespace
+{
+
+const char NODE_DIRECTORY[] = "/sys/devices/system/node";
+
+std::vector<int> allowed_cpus ()
+{
+    std::vector<int> cpus {};
+    cpu_set_t set;
+    CPU_ZERO (&set);
+    if (sched_getaffinity (0, sizeof (set), &set) != 0)
+        return cpus;
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (CPU_ISSET (cpu, &set))
+            cpus.push_back (cpu);
+    }
+    return cpus;
+}
+
+// "0-3,8,10-11" of the cpulist files
+std::vector<int> parse_cpu_list (const std::string& list)
+{
+    std::vector<int> cpus {};
+    std::stringstream ranges (list);
+    std::string range;
+    while (std::getline (ranges, range, ','))
+    {
+        if (range.empty () || range == "\n")
+            continue;
+
+        std::size_t dash = range.find ('-');
+        int first = std::atoi (range.c_str ());
+        int last = (dash == std::string::npos) ? first : std::atoi (range.c_str () + dash + 1);
+        for (int cpu = first; cpu <= last; ++cpu)
+            cpus.push_back (cpu);
+    }
+    return cpus;
+}
+
+} // namespace
+
+numa_topology_t detect_numa_topology ()
+{
+    std::vector<int> allowed = allowed_cpus ();
+    numa_topology_t topology {};
+
+    if (DIR* dir = opendir (NODE_DIRECTORY))
+    {
+        std::vector<int> nodes {};
+        while (dirent* entry = readdir (dir))
+        {
+            std::string name = entry->d_name;
+            if (name.size () > 4 && name.compare (0, 4, "node") == 0 &&
+                name.find_first_not_of ("0123456789", 4) == std::string::npos)
+                nodes.push_back (std::atoi (name.c_str () + 4));
+        }
+        closedir (dir);
+        std::sort (nodes.begin (), nodes.end ());
+
+        for (int node : nodes)
+        {
+            std::ifstream in (std::string (NODE_DIRECTORY) + "/node" + std::to_string (node) + "/cpulist");
+            std::string list;
+            std::getline (in, list);
+
+            std::vector<int> cpus {};
+            for (int cpu : parse_cpu_list (list))
+            {
+                if (std::find (allowed.begin (), allowed.end (), cpu) != allowed.end ())
+                    cpus.push_back (cpu);
+            }
+            if (!cpus.empty ())
+                topology.cpus_.push_back (cpus);
+        }
+    }
+
+    if (topology.cpus_.empty ())
+        topology.cpus_.push_back (allowed);
+    return topology;
+}
+
+numa_topology_t simulated_numa_topology (std::size_t num_nodes)
+{
+    std::vector<int> allowed = allowed_cpus ();
+    numa_topology_t topology {};
+    num_nodes = std::max<std::size_t> (num_nodes, 1);
+
+    for (std::size_t node = 0; node < num_nodes; ++node)
+    {
+        topology.cpus_.emplace_back (allowed.begin () + node * allowed.size () / num_nodes,
+                                     allowed.begin () + (node + 1) * allowed.size () / num_nodes);
+    }
+    return topology;
+}
+
+bool pin_current_thread (const std::vector<int>& cpus)
+{
+    if (cpus.empty ())
+        return false;
+
+    cpu_set_t set;
+    CPU_ZERO (&set);
+    for (int cpu : cpus)
+        CPU_SET (cpu, &set);
+    return sched_setaffinity (0, sizeof (set), &set) == 0;
+}
+
+// ----------------------------------------------------------------------------------
@@ -0,0 +1,35 @@
+#include "octree.hpp"
+
+// ------------------------------OCTREE_STATS_T--------------------------------------
+
+std::ostream& operator<< (std::ostream& out, const octree_stats_t& stats)
+{
+    out << "triangles:            " << stats.num_triangles_ << "\n"
+        << "leaves:               " << stats.num_leaves_ << "\n"
+        << "triangles in leaf:    min " << stats.min_tr_in_leaf_ << ", avg " << stats.avg_tr_in_leaf_
+                                        << ", max " << stats.max_tr_in_leaf_
+                                        << ", p99 " << stats.p99_tr_in_leaf_ << "\n"
+        << "duplication factor:   " << stats.duplication_factor_ << "\n"
+        << "leaves cut by depth:  " << stats.num_cut_leaves_ << "\n"
+        << "leaf depth histogram:";
+    for (std::size_t depth = 0; depth < stats.depth_histogram_.size (); ++depth)
+        out << " " << depth << ":" << stats.depth_histogram_[depth];
+
+    out << "\n"
+        << "pair tests:           " << stats.num_pair_tests_ << "\n"
+        << "hits:                 " << stats.num_hits_ << "\n"
+        << "bounding cube, ms:    " << stats.bounding_cube_ms_ << "\n"
+        << "build, ms:            " << stats.build_ms_ << "\n"
+        << "verify, ms:           " << stats.verify_ms_ << "\n";
+    return out;
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------INSTANTIATIONS--------------------------------------
+
+template class basic_octree_t<float>;
+template class basic_octree_t<double>;
+template class basic_octree_t<long double>;
+
+// ----------------------------------------------------------------------------------
@@ -0,0 +1,152 @@
+#include "out_of_core.hpp"
+
+#include <atomic>
+#include <queue>
+
+#include <unistd.h>
+
+// ------------------------------OUT_OF_CORE_STATS_T---------------------------------
+
+std::ostream& operator<< (std::ostream& out, const out_of_core_stats_t& stats)
+{
+    double duplication = (stats.num_triangles_ > 0) ?
+                         static_cast<double> (stats.num_bucket_triangles_) / stats.num_triangles_ : 0;
+    out << "triangles:            " << stats.num_triangles_ << "\n"
+        << "bucket capacity:      " << stats.bucket_capacity_ << "\n"
+        << "buckets:              " << stats.num_buckets_ << "\n"
+        << "splits:               " << stats.num_splits_ << "\n"
+        << "max bucket:           " << stats.max_bucket_triangles_ << "\n"
+        << "duplication factor:   " << duplication << "\n"
+        << "over budget:          " << stats.num_over_budget_ << "\n";
+    return out;
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------FILES-----------------------------------------------
+
+buffered_file_t::buffered_file_t (const std::string& path, const char* mode, std::size_t buffer_size) :
+    buffer_(buffer_size), file_(std::fopen (path.c_str (), mode))
+{
+    if (file_)
+        std::setvbuf (file_, buffer_.data (), _IOFBF, buffer_.size ());
+}
+
+bool buffered_file_t::close ()
+{
+    if (!file_)
+        return false;
+
+    bool ok = !std::ferror (file_);
+    ok = (std::fclose (file_) == 0) && ok;
+    file_ = nullptr;
+    return ok;
+}
+
+std::string temporary_file_path (const std::string& directory)
+{
+    static std::atomic<std::size_t> counter { 0 };
+    return directory + "/triangles_" + std::to_string (::getpid ()) + "_" + std::to_string (counter++) + ".tmp";
+}
+
+namespace
+{
+
+// one round of merge_number_files, at most OUT_OF_CORE_MAX_FANOUT paths
+bool merge_round (const std::vector<std::string>& paths, std::size_t buffer_size,
+                  const std::function<bool (std::uint64_t)>& callback)
+{
+    std::vector<std::unique_ptr<buffered_file_t>> files {};
+    for (const auto& path : paths)
+        files.push_back (std::make_unique<buffered_file_t> (path, "rb", buffer_size));
+
+    using head_t = std::pair<std::uint64_t, std::size_t>; // the next number of the file i
+    std::priority_queue<head_t, std::vector<head_t>, std::greater<head_t>> heads {};
+    bool ok = true;
+    auto read_next = [&] (std::size_t i)
+    {
+        std::uint64_t num = 0;
+        if (std::fread (&num, sizeof (num), 1, files[i]->get ()) == 1)
+            heads.push ({ num, i });
+        else
+            ok = ok && !std::ferror (files[i]->get ());
+    };
+
+    for (std::size_t i = 0; i < files.size () && ok; ++i)
+    {
+        ok = files[i]->is_open ();
+        if (ok)
+            read_next (i);
+    }
+
+    bool has_last = false;
+    std::uint64_t last = 0;
+    while (ok && !heads.empty ())
+    {
+        head_t head = heads.top ();
+        heads.pop ();
+        if (!has_last || head.first != last)
+        {
+            ok = callback (head.first);
+            has_last = true;
+            last = head.first;
+        }
+        read_next (head.second);
+    }
+
+    files.clear ();
+    for (const auto& path : paths)
+        std::remove (path.c_str ());
+    return ok;
+}
+
+} // namespace
+
+bool merge_number_files (std::vector<std::string> paths, const std::string& directory, std::size_t buffer_size,
+                         const std::function<bool (std::uint64_t)>& callback)
+{
+    while (paths.size () > OUT_OF_CORE_MAX_FANOUT)
+    {
+        std::vector<std::string> merged {};
+        bool ok = true;
+        for (std::size_t begin = 0; begin < paths.size (); begin += OUT_OF_CORE_MAX_FANOUT)
+        {
+            std::vector<std::string> group (paths.begin () + begin,
+                                            paths.begin () + std::min (begin + OUT_OF_CORE_MAX_FANOUT, paths.size ()));
+            if (!ok)
+            {
+                for (const auto& path : group)
+                    std::remove (path.c_str ());
+                continue;
+            }
+
+            merged.push_back (temporary_file_path (directory));
+            buffered_file_t out (merged.back (), "wb", buffer_size);
+            ok = out.is_open () && merge_round (group, buffer_size, [&] (std::uint64_t num)
+            {
+                return std::fwrite (&num, sizeof (num), 1, out.get ()) == 1;
+            });
+            ok = out.close () && ok;
+        }
+
+        if (!ok)
+        {
+            for (const auto& path : merged)
+                std::remove (path.c_str ());
+            return false;
+        }
+        paths.swap (merged);
+    }
+
+    return merge_round (paths, buffer_size, callback);
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------INSTANTIATIONS--------------------------------------
+
+template class basic_out_of_core_t<float>;
+template class basic_out_of_core_t<double>;
+template class basic_out_of_core_t<long double>;
+
+// ----------------------------------------------------------------------------------
@@ -0,0 +1,213 @@
+#include "output.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+// longest decimal std::size_t and the newline
+const std::size_t MAX_TEXT_NUMBER_SIZE = std::numeric_limits<std::size_t>::digits10 + 2;
+const std::size_t NUMBER_WRITER_BUFFER_SIZE = 1 << 20;
+
+// ------------------------------OUTPUT_FORMAT_T-------------------------------------
+
+const char* output_format_name (output_format_t format)
+{
+    switch (format)
+    {
+        case output_format_t::text:   return "text";
+        case output_format_t::uint32: return "uint32";
+        case output_format_t::bitmap: return "bitmap";
+    }
+    return "";
+}
+
+bool output_format_from_name (const std::string& name, output_format_t& format)
+{
+    for (auto tmp : { output_format_t::text, output_format_t::uint32, output_format_t::bitmap })
+    {
+        if (name == output_format_name (tmp))
+        {
+            format = tmp;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------FORMATTING------------------------------------------
+
+static std::size_t count_set (const std::vector<unsigned char>& flags)
+{
+    return std::count_if (flags.begin (), flags.end (), [] (unsigned char flag) { return flag != 0; });
+}
+
+static void format_text (const std::vector<unsigned char>& flags, std::vector<char>& buffer)
+{
+    std::size_t num_set = count_set (flags);
+    std::size_t old_size = buffer.size ();
+    buffer.resize (old_size + num_set * MAX_TEXT_NUMBER_SIZE);
+
+    char* pos = buffer.data () + old_size;
+    char* end = buffer.data () + buffer.size ();
+    for (std::size_t num = 0; num < flags.size (); ++num)
+    {
+        if (!flags[num])
+            continue;
+
+        pos = std::to_chars (pos, end, num).ptr;
+        *pos++ = '\n';
+    }
+    buffer.resize (pos - buffer.data ());
+}
+
+static bool format_uint32 (const std::vector<unsigned char>& flags, std::vector<char>& buffer)
+{
+    if (flags.size () > std::size_t (std::numeric_limits<std::uint32_t>::max ()) + 1)
+        return false;
+
+    std::size_t num_set = count_set (flags);
+    std::size_t old_size = buffer.size ();
+    buffer.resize (old_size + num_set * sizeof (std::uint32_t));
+
+    char* pos = buffer.data () + old_size;
+    for (std::size_t num = 0; num < flags.size (); ++num)
+    {
+        if (!flags[num])
+            continue;
+
+        std::uint32_t value = static_cast<std::uint32_t> (num);
+        std::memcpy (pos, &value, sizeof (value));
+        pos += sizeof (value);
+    }
+    return true;
+}
+
+static void format_bitmap (const std::vector<unsigned char>& flags, std::vector<char>& buffer)
+{
+    std::size_t old_size = buffer.size ();
+    buffer.resize (old_size + (flags.size () + 7) / 8);
+
+    char* bytes = buffer.data () + old_size;
+    for (std::size_t num = 0; num < flags.size (); ++num)
+    {
+        if (flags[num])
+            bytes[num / 8] = static_cast<char> (bytes[num / 8] | (1 << (num % 8)));
+    }
+}
+
+bool format_intersections (const std::vector<unsigned char>& flags, output_format_t format,
+                           std::vector<char>& buffer)
+{
+    switch (format)
+    {
+        case output_format_t::text:   format_text (flags, buffer); return true;
+        case output_format_t::uint32: return format_uint32 (flags, buffer);
+        case output_format_t::bitmap: format_bitmap (flags, buffer); return true;
+    }
+    return false;
+}
+
+void format_batch_header (const std::vector<unsigned char>& flags, output_format_t format,
+                          std::vector<char>& buffer)
+{
+    std::size_t num_set = count_set (flags);
+    if (format == output_format_t::text)
+    {
+        std::size_t old_size = buffer.size ();
+        buffer.resize (old_size + MAX_TEXT_NUMBER_SIZE);
+
+        char* pos = std::to_chars (buffer.data () + old_size, buffer.data () + buffer.size (), num_set).ptr;
+        *pos++ = '\n';
+        buffer.resize (pos - buffer.data ());
+    }
+    else if (format == output_format_t::uint32)
+    {
+        std::uint32_t value = static_cast<std::uint32_t> (num_set);
+        const char* bytes = reinterpret_cast<const char*> (&value);
+        buffer.insert (buffer.end (), bytes, bytes + sizeof (value));
+    }
+}
+
+bool write_buffer (std::FILE* file, const std::vector<char>& buffer)
+{
+    if (buffer.empty ())
+        return true;
+
+    return std::fwrite (buffer.data (), 1, buffer.size (), file) == buffer.size () &&
+           std::fflush (file) == 0;
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------NUMBER_WRITER_T-------------------------------------
+
+number_writer_t::number_writer_t (std::FILE* file, output_format_t format, std::size_t num_triangles) :
+    file_(file), format_(format), num_triangles_(num_triangles)
+{
+    buffer_.reserve (NUMBER_WRITER_BUFFER_SIZE + MAX_TEXT_NUMBER_SIZE);
+}
+
+bool number_writer_t::flush ()
+{
+    ok_ = ok_ && (buffer_.empty () || std::fwrite (buffer_.data (), 1, buffer_.size (), file_) == buffer_.size ());
+    num_written_ += buffer_.size ();
+    buffer_.clear ();
+    return ok_;
+}
+
+bool number_writer_t::add (std::size_t num)
+{
+    if (!ok_)
+        return false;
+
+    if (format_ == output_format_t::text)
+    {
+        std::size_t old_size = buffer_.size ();
+        buffer_.resize (old_size + MAX_TEXT_NUMBER_SIZE);
+        char* pos = std::to_chars (buffer_.data () + old_size, buffer_.data () + buffer_.size (), num).ptr;
+        *pos++ = '\n';
+        buffer_.resize (pos - buffer_.data ());
+    }
+    else if (format_ == output_format_t::uint32)
+    {
+        if (num > std::numeric_limits<std::uint32_t>::max ())
+            return ok_ = false;
+
+        std::uint32_t value = static_cast<std::uint32_t> (num);
+        const char* bytes = reinterpret_cast<const char*> (&value);
+        buffer_.insert (buffer_.end (), bytes, bytes + sizeof (value));
+    }
+    else
+    {
+        while (num_written_ + buffer_.size () <= num / 8)
+        {
+            if (buffer_.size () >= NUMBER_WRITER_BUFFER_SIZE && !flush ())
+                return false;
+            buffer_.push_back (0);
+        }
+        char& byte = buffer_[num / 8 - num_written_];
+        byte = static_cast<char> (byte | (1 << (num % 8)));
+    }
+
+    return (buffer_.size () < NUMBER_WRITER_BUFFER_SIZE) || flush ();
+}
+
+bool number_writer_t::finish ()
+{
+    if (format_ == output_format_t::bitmap)
+    {
+        while (ok_ && num_written_ + buffer_.size () < (num_triangles_ + 7) / 8)
+        {
+            buffer_.push_back (0);
+            if (buffer_.size () >= NUMBER_WRITER_BUFFER_SIZE)
+                flush ();
+        }
+    }
+    return flush () && std::fflush (file_) == 0;
+}
+
+// ----------------------------------------------------------------------------------
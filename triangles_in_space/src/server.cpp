@@ -0,0 +1,150 @@
+#include "server.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <streambuf>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// ------------------------------FD_STREAMBUF_T--------------------------------------
+
+namespace
+{
+
+const std::size_t FD_BUFFER_SIZE = 1 << 16;
+
+// buffered stream over a connected socket
+class fd_streambuf_t : public std::streambuf
+{
+private:
+    int fd_;
+    std::vector<char> in_buffer_;
+    std::vector<char> out_buffer_;
+
+    bool flush_buffer ()
+    {
+        const char* data = pbase ();
+        std::size_t size = pptr () - pbase ();
+        while (size > 0)
+        {
+            // a client that closed the connection is an error of the write, not SIGPIPE
+            ssize_t written = ::send (fd_, data, size, MSG_NOSIGNAL);
+            if (written <= 0)
+                return false;
+
+            data += written;
+            size -= written;
+        }
+        setp (out_buffer_.data (), out_buffer_.data () + out_buffer_.size ());
+        return true;
+    }
+
+protected:
+    int_type underflow () override
+    {
+        ssize_t num = ::read (fd_, in_buffer_.data (), in_buffer_.size ());
+        if (num <= 0)
+            return traits_type::eof ();
+
+        setg (in_buffer_.data (), in_buffer_.data (), in_buffer_.data () + num);
+        return traits_type::to_int_type (*gptr ());
+    }
+
+    int_type overflow (int_type c) override
+    {
+        if (!flush_buffer ())
+            return traits_type::eof ();
+
+        if (!traits_type::eq_int_type (c, traits_type::eof ()))
+            sputc (traits_type::to_char_type (c));
+        return traits_type::not_eof (c);
+    }
+
+    int sync () override { return flush_buffer () ? 0 : -1; }
+
+public:
+    explicit fd_streambuf_t (int fd) : fd_ (fd), in_buffer_ (FD_BUFFER_SIZE), out_buffer_ (FD_BUFFER_SIZE)
+    {
+        setg (in_buffer_.data (), in_buffer_.data (), in_buffer_.data ());
+        setp (out_buffer_.data (), out_buffer_.data () + out_buffer_.size ());
+    }
+};
+
+} // namespace
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------UNIX_SOCKET-----------------------------------------
+
+// removes the socket at path left by an earlier server; false if path is not a socket,
+// such a file is not ours to remove
+static bool remove_socket (const std::string& path)
+{
+    struct stat status {};
+    if (::lstat (path.c_str (), &status) < 0)
+        return errno == ENOENT;
+
+    return S_ISSOCK (status.st_mode) && ::unlink (path.c_str ()) == 0;
+}
+
+bool serve_unix_socket (const std::string& path, const std::function<bool (std::istream&, std::ostream&)>& serve)
+{
+    sockaddr_un address {};
+    if (path.size () >= sizeof (address.sun_path))
+        return false;
+
+    address.sun_family = AF_UNIX;
+    std::strcpy (address.sun_path, path.c_str ());
+
+    int listener = ::socket (AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+        return false;
+
+    if (!remove_socket (path) ||
+        ::bind (listener, reinterpret_cast<sockaddr*> (&address), sizeof (address)) < 0 ||
+        ::listen (listener, 1) < 0)
+    {
+        ::close (listener);
+        return false;
+    }
+
+    bool ok = true;
+    bool stop = false;
+    while (!stop)
+    {
+        int connection = ::accept (listener, nullptr, nullptr);
+        if (connection < 0)
+        {
+            // a signal interrupts the wait for a client, not the server
+            if (errno == EINTR)
+                continue;
+
+            ok = false;
+            break;
+        }
+
+        fd_streambuf_t buffer (connection);
+        std::istream in (&buffer);
+        std::ostream out (&buffer);
+        stop = serve (in, out);
+        out.flush ();
+        ::close (connection);
+    }
+
+    ::close (listener);
+    remove_socket (path);
+    return ok;
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------INSTANTIATIONS--------------------------------------
+
+template class basic_server_t<float>;
+template class basic_server_t<double>;
+template class basic_server_t<long double>;
+
+// ----------------------------------------------------------------------------------
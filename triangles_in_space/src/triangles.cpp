@@ -0,0 +1,41 @@
+#include "triangles.hpp"
+
+// ------------------------------KERNEL_T--------------------------------------------
+
+std::string kernel_name (kernel_t kernel)
+{
+    switch (kernel)
+    {
+        case kernel_t::epsilon:          return "epsilon";
+        case kernel_t::robust:           return "robust";
+        case kernel_t::guigue_devillers: return "guigue_devillers";
+    }
+    return "unknown";
+}
+
+bool kernel_from_name (const std::string& name, kernel_t& kernel)
+{
+    for (auto tmp : ALL_KERNELS)
+    {
+        if (kernel_name (tmp) == name)
+        {
+            kernel = tmp;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------INSTANTIATIONS--------------------------------------
+
+// The geometry core is instantiated here once for every scalar type. The headers
+// declare these instantiations extern, so other translation units inline what they
+// call and do not emit their own copies of the rest.
+
+template class basic_triangle_t<float>;
+template class basic_triangle_t<double>;
+template class basic_triangle_t<long double>;
+
+// ----------------------------------------------------------------------------------
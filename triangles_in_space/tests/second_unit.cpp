@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+
+#include <set>
+#include <sstream>
+#include <vector>
+
+#include "./../include/triangles.hpp"
+#include "./../include/octree.hpp"
+
+// The headers are included by a second translation unit of the same executable,
+// a function defined in a header but not inline breaks the link.
+
+// ------------------------------TESTING_SECOND_UNIT---------------------------------
+
+TEST (second_unit, read_and_intersect)
+{
+    std::istringstream in ("0 0 0  1 0 0  0 1 0\n"
+                           "0.2 0.2 -1  0.2 0.2 1  0.3 0.3 1\n"
+                           "5 5 5  6 5 5  5 6 5\n");
+
+    std::vector<triangle_t> array_triangle;
+    for (int i = 0; i < 3; ++i)
+    {
+        point_t a {}, b {}, c {};
+        in >> a >> b >> c;
+        array_triangle.push_back ({ a, b, c });
+    }
+
+    octree_t tree (array_triangle);
+    std::set<std::size_t> expected { 0, 1 };
+    EXPECT_EQ (tree.get_num_tr_intersection (), expected);
+
+    std::ostringstream out;
+    out << tree.get_stats ();
+    EXPECT_FALSE (out.str ().empty ());
+
+    kernel_t kernel {};
+    EXPECT_TRUE (kernel_from_name (kernel_name (kernel_t::robust), kernel));
+    EXPECT_EQ (kernel, kernel_t::robust);
+}
+
+// ----------------------------------------------------------------------------------
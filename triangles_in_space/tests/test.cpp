@@ -1,6 +1,29 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
 #include "./../include/triangles.hpp"
+#include "./../include/octree.hpp"
+#include "./../include/batch.hpp"
+#include "./../include/numa.hpp"
+#include "./../include/out_of_core.hpp"
+#include "./../include/output.hpp"
+#include "./../include/reorder.hpp"
+#include "./../include/server.hpp"
 
 // ------------------------------TESTING_SCALAR_PRODUCT------------------------------
 
@@ -144,6 +167,15 @@ TEST (test_vector, cross_product_negative)
     EXPECT_DOUBLE_EQ (answer.get_z (), -3.63);
 }
 
+TEST (test_vector, cross_product_constexpr)
+{
+    constexpr vector_t vec_1 { point_t (0, 0, 0), point_t (1, 0, 0) };
+    constexpr vector_t vec_2 { 0, 1, 0 };
+    constexpr vector_t answer = vec_1.cross_product (vec_2);
+    static_assert (answer.get_z () == 1 && answer.scalar_product (vec_1) == 0, "");
+    EXPECT_TRUE ((point_t (1, 2, 3) + point_t (1, 1, 1)) == point_t (2, 3, 4));
+}
+
 // ----------------------------------------------------------------------------------
 
 // ------------------------------TESTING_POINT_LIE_IN_PLANE_TR-----------------------
@@ -1747,3 +1779,1518 @@ TEST(intersection_tr1, test10)
 }
 
 // ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_OCTREE--------------------------------------
+
+static std::vector<triangle_t> generate_triangles (std::size_t N, double space, double size, unsigned seed)
+{
+    std::mt19937 gen (seed);
+    std::uniform_real_distribution<double> pos (-space, space);
+    std::uniform_real_distribution<double> offset (-size, size);
+
+    std::vector<triangle_t> array_triangle;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        point_t p (pos (gen), pos (gen), pos (gen));
+        array_triangle.push_back ({ p,
+                                    p + point_t (offset (gen), offset (gen), offset (gen)),
+                                    p + point_t (offset (gen), offset (gen), offset (gen)) });
+    }
+    return array_triangle;
+}
+
+const double NEAR_MISS_SIZES[] = { 0.01, 0.001 };
+const double NEAR_MISS_GAPS[] = { 0, 1e-8, 5e-8, 2e-7, 1e-6, 1e-5, 1e-4, 1e-3, 1e-2 };
+const std::size_t NEAR_MISS_LAYOUTS = 3;
+
+// Pairs of small triangles for every size and gap: side by side in one plane, on
+// parallel planes and perpendicular; the gap of every pair straddles a plane of the
+// octree cells (x = 0 or z = 0). The pair i is the triangles 2 i and 2 i + 1, the
+// gap of the pair i is NEAR_MISS_GAPS[i / NEAR_MISS_LAYOUTS % 9].
+static std::vector<triangle_t> near_miss_triangles ()
+{
+    std::vector<triangle_t> array_triangle;
+    for (double s : NEAR_MISS_SIZES)
+        for (double gap : NEAR_MISS_GAPS)
+            for (std::size_t layout = 0; layout < NEAR_MISS_LAYOUTS; ++layout)
+            {
+                double y = 0.05 * (array_triangle.size () / 2) - 1.35;
+                if (layout == 0)
+                {
+                    point_t o (-s - gap / 2, y, 0.3);
+                    array_triangle.push_back ({ o, o + point_t (s, 0, 0), o + point_t (0, s, 0) });
+                    array_triangle.push_back ({ o + point_t (s + gap, 0, 0), o + point_t (2 * s + gap, 0, 0),
+                                                o + point_t (s + gap, s, 0) });
+                }
+                else if (layout == 1)
+                {
+                    point_t o (0.3, y, -gap / 2);
+                    array_triangle.push_back ({ o, o + point_t (s, 0, 0), o + point_t (0, s, 0) });
+                    array_triangle.push_back ({ o + point_t (0, 0, gap), o + point_t (s, 0, gap),
+                                                o + point_t (0, s, gap) });
+                }
+                else
+                {
+                    point_t o (-s - gap / 2, y, -0.3);
+                    array_triangle.push_back ({ o, o + point_t (s, 0, 0), o + point_t (0, s, 0) });
+                    array_triangle.push_back ({ o + point_t (s + gap, 0, -s / 2), o + point_t (s + gap, s, -s / 2),
+                                                o + point_t (s + gap, 0, s / 2) });
+                }
+            }
+    return array_triangle;
+}
+
+TEST (octree, self_intersection_naive)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (2000, 50.0, 2.0, 1);
+
+    std::set<std::size_t> expected {};
+    for (std::size_t i = 0; i < array_triangle.size (); ++i)
+        for (std::size_t j = i + 1; j < array_triangle.size (); ++j)
+            if (array_triangle[i].check_intersection (array_triangle[j]))
+            {
+                expected.insert (i);
+                expected.insert (j);
+            }
+
+    octree_t tree (array_triangle);
+    EXPECT_EQ (tree.get_num_tr_intersection (), expected);
+
+    thread_pool_t pool (4);
+    EXPECT_EQ (tree.get_num_tr_intersection (pool), expected);
+}
+
+TEST (octree, intersecting_pairs)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (2000, 30.0, 2.0, 4);
+
+    std::set<std::pair<std::size_t, std::size_t>> expected {};
+    for (std::size_t i = 0; i < array_triangle.size (); ++i)
+        for (std::size_t j = i + 1; j < array_triangle.size (); ++j)
+            if (array_triangle[i].check_intersection (array_triangle[j]))
+                expected.insert ({ i, j });
+
+    octree_t tree (array_triangle);
+
+    std::vector<std::pair<std::size_t, std::size_t>> answer {};
+    EXPECT_TRUE (tree.for_each_intersecting_pair ([&] (std::size_t i, std::size_t j)
+    {
+        answer.push_back ({ i, j });
+        return true;
+    }));
+
+    // every pair is reported exactly once
+    EXPECT_EQ (answer.size (), expected.size ());
+    std::set<std::pair<std::size_t, std::size_t>> answer_set (answer.begin (), answer.end ());
+    EXPECT_EQ (answer_set, expected);
+
+    std::pair<std::size_t, std::size_t> buffer[3] {};
+    EXPECT_EQ (tree.get_intersecting_pairs (buffer, 3), 3);
+    EXPECT_EQ (buffer[0], answer[0]);
+    EXPECT_EQ (buffer[2], answer[2]);
+    EXPECT_TRUE (tree.has_intersection ());
+}
+
+TEST (octree, stats)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (2000, 30.0, 2.0, 11);
+    octree_t tree (array_triangle);
+    std::set<std::size_t> num_tr = tree.get_num_tr_intersection ();
+
+    octree_stats_t stats = tree.get_stats ();
+    EXPECT_EQ (stats.num_triangles_, 2000);
+    EXPECT_GT (stats.num_leaves_, 1);
+    EXPECT_LE (stats.min_tr_in_leaf_, stats.p99_tr_in_leaf_);
+    EXPECT_LE (stats.p99_tr_in_leaf_, stats.max_tr_in_leaf_);
+    EXPECT_GE (stats.duplication_factor_, 1.0);
+
+    std::size_t num_leaves = 0;
+    for (auto tmp : stats.depth_histogram_)
+        num_leaves += tmp;
+    EXPECT_EQ (num_leaves, stats.num_leaves_);
+
+    EXPECT_LE (stats.num_pair_tests_, tree.count_candidate_pairs ());
+    EXPECT_GE (stats.num_hits_ * 2, num_tr.size ());
+    EXPECT_LE (stats.num_hits_, stats.num_pair_tests_);
+}
+
+TEST (octree, bounding_cube)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (5000, 50.0, 2.0, 12);
+    array_triangle.push_back ({ point_t (0, 0, -70), point_t (1, 0, -70), point_t (0, 1, -71) });
+
+    thread_pool_t pool (3);
+    octree_t tree (array_triangle, pool);
+    EXPECT_DOUBLE_EQ (tree.count_bounding_cube (), 128.0);
+    EXPECT_DOUBLE_EQ (tree.count_bounding_cube (pool), 128.0);
+    EXPECT_EQ (tree.get_num_tr_intersection (pool), tree.get_num_tr_intersection ());
+}
+
+TEST (octree, no_intersection)
+{
+    std::vector<triangle_t> array_triangle {};
+    for (int i = 0; i < 100; ++i)
+        array_triangle.push_back ({ point_t (i, 0, 0), point_t (i + 0.5, 0, 0), point_t (i, 0.5, 0) });
+
+    octree_t tree (array_triangle);
+    EXPECT_FALSE (tree.has_intersection ());
+    EXPECT_TRUE (tree.get_num_tr_intersection ().empty ());
+}
+
+TEST (octree, two_meshes_naive)
+{
+    std::vector<triangle_t> array_a = generate_triangles (1500, 50.0, 2.0, 2);
+    std::vector<triangle_t> array_b = generate_triangles (300, 50.0, 4.0, 3);
+
+    std::set<std::size_t> expected_a {};
+    std::set<std::size_t> expected_b {};
+    for (std::size_t i = 0; i < array_a.size (); ++i)
+        for (std::size_t j = 0; j < array_b.size (); ++j)
+            if (array_a[i].check_intersection (array_b[j]))
+            {
+                expected_a.insert (i);
+                expected_b.insert (j);
+            }
+
+    auto answer = get_num_tr_intersection (array_a, array_b);
+    EXPECT_FALSE (expected_a.empty ());
+    EXPECT_EQ (answer.first, expected_a);
+    EXPECT_EQ (answer.second, expected_b);
+
+    auto answer_swap = get_num_tr_intersection (array_b, array_a);
+    EXPECT_EQ (answer_swap.first, expected_b);
+    EXPECT_EQ (answer_swap.second, expected_a);
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_RAY-----------------------------------------
+
+TEST (ray, triangle_hit)
+{
+    triangle_t tr (point_t (0, 0, 0), point_t (2, 0, 0), point_t (0, 2, 0));
+    double t = 0;
+
+    EXPECT_TRUE (tr.check_intersection_ray (ray_t (point_t (0.5, 0.5, 4), vector_t (0, 0, -2)), t));
+    EXPECT_DOUBLE_EQ (t, 2.0);
+
+    EXPECT_FALSE (tr.check_intersection_ray (ray_t (point_t (0.5, 0.5, 4), vector_t (0, 0, 2)), t));
+    EXPECT_FALSE (tr.check_intersection_ray (ray_t (point_t (1.5, 1.5, 4), vector_t (0, 0, -1)), t));
+    EXPECT_FALSE (tr.check_intersection_ray (ray_t::segment (point_t (0.5, 0.5, 4), point_t (0.5, 0.5, 1)), t));
+    EXPECT_TRUE (tr.check_intersection_ray (ray_t::segment (point_t (0.5, 0.5, 4), point_t (0.5, 0.5, -1)), t));
+    EXPECT_DOUBLE_EQ (t, 0.8);
+}
+
+TEST (ray, octree_naive)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (3000, 50.0, 3.0, 5);
+    octree_t tree (array_triangle);
+
+    std::mt19937 gen (6);
+    std::uniform_real_distribution<double> pos (-60.0, 60.0);
+
+    std::vector<ray_t> rays {};
+    for (std::size_t i = 0; i < 200; ++i)
+    {
+        point_t origin (pos (gen), pos (gen), pos (gen));
+        point_t target (pos (gen), pos (gen), pos (gen));
+        rays.push_back (i % 2 ? ray_t::segment (origin, target) : ray_t (origin, vector_t (origin, target)));
+    }
+
+    thread_pool_t pool (3);
+    std::vector<ray_hit_t> first_hits = tree.get_first_hit (rays, pool);
+    std::vector<ray_hit_t> any_hits   = tree.get_any_hit (rays, pool);
+
+    std::size_t num_hits = 0;
+    for (std::size_t i = 0; i < rays.size (); ++i)
+    {
+        ray_hit_t expected {};
+        for (std::size_t j = 0; j < array_triangle.size (); ++j)
+        {
+            double t = 0;
+            if (array_triangle[j].check_intersection_ray (rays[i], t) && t < expected.t_)
+                expected = { true, j, t };
+        }
+
+        num_hits += expected.hit_;
+        EXPECT_EQ (first_hits[i].hit_, expected.hit_);
+        EXPECT_EQ (any_hits[i].hit_, expected.hit_);
+        if (expected.hit_)
+        {
+            EXPECT_EQ (first_hits[i].num_tr_, expected.num_tr_);
+            EXPECT_DOUBLE_EQ (first_hits[i].t_, expected.t_);
+        }
+    }
+    EXPECT_GT (num_hits, 0);
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_RANGE_QUERY---------------------------------
+
+TEST (range_query, closest_point)
+{
+    triangle_t tr (point_t (0, 0, 0), point_t (2, 0, 0), point_t (0, 2, 0));
+
+    point_t p1 = tr.closest_point ({ 0.5, 0.5, 3 });
+    EXPECT_DOUBLE_EQ (p1.x_, 0.5);
+    EXPECT_DOUBLE_EQ (p1.y_, 0.5);
+    EXPECT_DOUBLE_EQ (p1.z_, 0.0);
+
+    point_t p2 = tr.closest_point ({ -1, -1, 1 });
+    EXPECT_TRUE (p2 == point_t (0, 0, 0));
+
+    point_t p3 = tr.closest_point ({ 2, 2, 0 });
+    EXPECT_TRUE (p3 == point_t (1, 1, 0));
+
+    triangle_t line (point_t (0, 0, 0), point_t (1, 0, 0), point_t (2, 0, 0));
+    point_t p4 = line.closest_point ({ 1.5, 1, 0 });
+    EXPECT_TRUE (p4 == point_t (1.5, 0, 0));
+}
+
+TEST (range_query, octree_naive)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (3000, 50.0, 3.0, 7);
+    octree_t tree (array_triangle);
+
+    std::mt19937 gen (8);
+    std::uniform_real_distribution<double> pos (-60.0, 60.0);
+    std::uniform_real_distribution<double> size (0.0, 10.0);
+
+    std::vector<std::pair<point_t, point_t>> boxes {};
+    std::vector<std::pair<point_t, double>> spheres {};
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+        point_t p (pos (gen), pos (gen), pos (gen));
+        boxes.push_back ({ p, p + point_t (size (gen), -size (gen), size (gen)) });
+        spheres.push_back ({ p, size (gen) });
+    }
+
+    thread_pool_t pool (3);
+    std::vector<std::vector<std::size_t>> answer_box    = tree.get_num_tr_in_box (boxes, pool);
+    std::vector<std::vector<std::size_t>> answer_sphere = tree.get_num_tr_in_sphere (spheres, pool);
+
+    std::size_t num_found = 0;
+    for (std::size_t i = 0; i < boxes.size (); ++i)
+    {
+        std::vector<std::size_t> expected_box {};
+        std::vector<std::size_t> expected_sphere {};
+        for (std::size_t j = 0; j < array_triangle.size (); ++j)
+        {
+            if (array_triangle[j].triangle_lie_in_space (boxes[i].first, boxes[i].second))
+                expected_box.push_back (j);
+
+            vector_t vec { spheres[i].first, array_triangle[j].closest_point (spheres[i].first) };
+            if (vec.scalar_product (vec) <= spheres[i].second * spheres[i].second)
+                expected_sphere.push_back (j);
+        }
+
+        num_found += expected_box.size () + expected_sphere.size ();
+        EXPECT_EQ (answer_box[i], expected_box);
+        EXPECT_EQ (answer_sphere[i], expected_sphere);
+    }
+    EXPECT_GT (num_found, 0);
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_DISTANCE------------------------------------
+
+TEST (distance, triangle_triangle)
+{
+    triangle_t tr1 (point_t (0, 0, 0), point_t (2, 0, 0), point_t (0, 2, 0));
+    triangle_t tr2 (point_t (0, 0, 3), point_t (2, 0, 3), point_t (0, 2, 3));
+    triangle_t tr3 (point_t (3, 3, -1), point_t (3, 3, 1), point_t (5, 5, 0));
+    triangle_t tr4 (point_t (1, 1, -1), point_t (0, 0, 1), point_t (2, 0, 1));
+
+    EXPECT_DOUBLE_EQ (tr1.distance (tr2), 3.0);
+    EXPECT_DOUBLE_EQ (tr1.distance (tr3), 2 * std::sqrt (2.0));
+    EXPECT_DOUBLE_EQ (tr1.distance (tr4), 0.0);
+
+    EXPECT_DOUBLE_EQ (triangle_t::distance_segment_segment ({ 0, 0, 0 }, { 2, 0, 0 },
+                                                            { 1, -1, 1 }, { 1, 1, 1 }), 1.0);
+}
+
+TEST (distance, octree_naive)
+{
+    std::vector<triangle_t> array_a = generate_triangles (2000, 50.0, 1.0, 9);
+    std::vector<triangle_t> array_b = generate_triangles (150, 50.0, 1.0, 10);
+
+    const double tolerance = 1.0;
+    distance_t expected {};
+    std::set<std::pair<std::size_t, std::size_t>> expected_pairs {};
+    for (std::size_t i = 0; i < array_a.size (); ++i)
+        for (std::size_t j = 0; j < array_b.size (); ++j)
+        {
+            double distance = array_a[i].distance (array_b[j]);
+            if (distance < expected.distance_)
+                expected = { distance, i, j };
+            if (distance <= tolerance)
+                expected_pairs.insert ({ i, j });
+        }
+
+    distance_t answer = get_min_distance (array_a, array_b);
+    EXPECT_DOUBLE_EQ (answer.distance_, expected.distance_);
+    EXPECT_EQ (answer.num_a_, expected.num_a_);
+    EXPECT_EQ (answer.num_b_, expected.num_b_);
+
+    std::vector<std::pair<std::size_t, std::size_t>> answer_pairs {};
+    for_each_pair_within_distance (array_b, array_a, tolerance, [&] (std::size_t j, std::size_t i, double)
+    {
+        answer_pairs.push_back ({ i, j });
+        return true;
+    });
+
+    std::set<std::pair<std::size_t, std::size_t>> answer_set (answer_pairs.begin (), answer_pairs.end ());
+    EXPECT_FALSE (expected_pairs.empty ());
+    EXPECT_EQ (answer_pairs.size (), answer_set.size ());
+    EXPECT_EQ (answer_set, expected_pairs);
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_BUILD_TRIANGLES-----------------------------
+
+TEST (build_triangles, same_as_constructor)
+{
+    std::mt19937 gen (7);
+    std::uniform_real_distribution<double> pos (-100.0, 100.0);
+
+    std::vector<double> coords {};
+    for (std::size_t i = 0; i < 1000; ++i)
+    {
+        point_t p (pos (gen), pos (gen), pos (gen));
+        point_t d (pos (gen), pos (gen), pos (gen));
+        point_t q (pos (gen), pos (gen), pos (gen));
+        if (i % 3 == 0)
+        {
+            d = p;
+            q = p;
+        }
+        else if (i % 3 == 1)
+            q = p + (d - p) * 2;
+
+        for (const point_t& tmp : { p, d, q })
+        {
+            coords.push_back (tmp.x_);
+            coords.push_back (tmp.y_);
+            coords.push_back (tmp.z_);
+        }
+    }
+
+    thread_pool_t pool (4);
+    std::vector<triangle_t> array_triangle = build_triangles (coords, pool);
+    ASSERT_EQ (array_triangle.size (), 1000);
+
+    for (std::size_t i = 0; i < array_triangle.size (); ++i)
+    {
+        const double* v = coords.data () + 9 * i;
+        triangle_t expected ({ v[0], v[1], v[2] }, { v[3], v[4], v[5] }, { v[6], v[7], v[8] });
+        const triangle_t& answer = array_triangle[i];
+
+        EXPECT_EQ (answer.get_flags (), expected.get_flags ());
+        EXPECT_EQ (answer.triangle_is_point (), i % 3 == 0);
+        EXPECT_EQ (answer.triangle_is_line (), i % 3 == 1);
+        EXPECT_EQ (answer.get_N ().get_x (), expected.get_N ().get_x ());
+        EXPECT_EQ (answer.get_N ().get_y (), expected.get_N ().get_y ());
+        EXPECT_EQ (answer.get_N ().get_z (), expected.get_N ().get_z ());
+        EXPECT_TRUE (answer.get_p_min () == expected.get_p_min ());
+        EXPECT_TRUE (answer.get_p_max () == expected.get_p_max ());
+    }
+}
+
+TEST (build_triangles, distance_point_plane_tr)
+{
+    triangle_t tr ({ 0, 0, 2 }, { 3, 0, 2 }, { 0, 5, 2 });
+
+    EXPECT_DOUBLE_EQ (tr.distance_point_plane_tr ({ 1, 1, 7 }), 5);
+    EXPECT_DOUBLE_EQ (tr.distance_point_plane_tr ({ 1, 1, -1 }), -3);
+    EXPECT_NEAR (tr.get_n ().get_z (), 1, EPSILON);
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_ROBUST--------------------------------------
+
+TEST (predicates, orient2d_exact_sign)
+{
+    // the double evaluation of these determinants is 0
+    double y = std::nextafter (0.5, 1.0);
+    EXPECT_GT (predicates::orient2d (0.5, y, 12, 12, 24, 24), 0);
+    EXPECT_LT (predicates::orient2d (y, 0.5, 12, 12, 24, 24), 0);
+    EXPECT_EQ (predicates::orient2d (0.5, 0.5, 12, 12, 24, 24), 0);
+}
+
+TEST (predicates, orient3d_far_from_origin)
+{
+    double z = 1e6 + 0x1.0p-30;
+    EXPECT_GT (predicates::orient3d (1e6, 1e6, 1e6, 1e6 + 1, 1e6, 1e6, 1e6, 1e6 + 1, 1e6, 1e6, 1e6, z), 0);
+    EXPECT_EQ (predicates::orient3d (1e6, 1e6, 1e6, 1e6 + 1, 1e6, 1e6, 1e6, 1e6 + 1, 1e6, 3e6, 3e6, 1e6), 0);
+}
+
+TEST (intersection_robust, far_from_origin)
+{
+    double base = 1e6;
+    triangle_t tr ({ base, base, base }, { base + 1, base, base }, { base, base + 1, base });
+
+    // a vertex 2^-30 above the plane of tr, closer than EPSILON
+    triangle_t above ({ base + 0.25, base + 0.25, base + 0x1.0p-30 },
+                      { base + 0.25, base + 0.25, base + 1 },
+                      { base + 0.5,  base + 0.25, base + 1 });
+    triangle_t touching ({ base + 0.25, base + 0.25, base },
+                         { base + 0.25, base + 0.25, base + 1 },
+                         { base + 0.5,  base + 0.25, base + 1 });
+
+    EXPECT_FALSE (tr.check_intersection (above, kernel_t::robust));
+    EXPECT_FALSE (above.check_intersection (tr, kernel_t::robust));
+    EXPECT_TRUE (tr.check_intersection (touching, kernel_t::robust));
+    EXPECT_TRUE (touching.check_intersection (tr, kernel_t::robust));
+}
+
+TEST (intersection_robust, small_scale)
+{
+    double size = 1e-4;
+    triangle_t tr ({ 0, 0, 0 }, { size, 0, 0 }, { 0, size, 0 });
+    triangle_t shifted ({ 0, 0, 1e-8 }, { size, 0, 1e-8 }, { 0, size, 1e-8 });
+    triangle_t crossing ({ size / 4, size / 4, -size }, { size / 4, size / 4, size }, { size / 2, size / 4, size });
+
+    EXPECT_FALSE (tr.check_intersection (shifted, kernel_t::robust));
+    EXPECT_TRUE (tr.check_intersection (crossing, kernel_t::robust));
+}
+
+TEST (intersection_robust, degenerate)
+{
+    triangle_t point ({ 0.5, 0.25, 0 }, { 0.5, 0.25, 0 }, { 0.5, 0.25, 0 });
+    triangle_t line ({ 0, 0, 0 }, { 2, 1, 0 }, { 1, 0.5, 0 });
+    triangle_t line_crossing ({ 0, 1, 0 }, { 1, 0, 0 }, { 0.5, 0.5, 0 });
+    triangle_t line_apart ({ 0, 1, 1e-9 }, { 1, 0, 1e-9 }, { 0.5, 0.5, 1e-9 });
+    triangle_t line_vertical ({ 0.25, 0.25, -1 }, { 0.25, 0.25, 1 }, { 0.25, 0.25, 0 });
+    triangle_t tr ({ 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 });
+
+    EXPECT_TRUE (line.check_intersection (point, kernel_t::robust));
+    EXPECT_TRUE (point.check_intersection (point, kernel_t::robust));
+    EXPECT_TRUE (line.check_intersection (line_crossing, kernel_t::robust));
+    EXPECT_FALSE (line.check_intersection (line_apart, kernel_t::robust));
+    EXPECT_TRUE (tr.check_intersection (line_vertical, kernel_t::robust));
+    EXPECT_TRUE (tr.check_intersection (point, kernel_t::robust));
+    EXPECT_FALSE (tr.check_intersection (line_apart, kernel_t::robust));
+}
+
+TEST (octree, robust_kernel)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (2000, 50.0, 2.0, 11);
+
+    std::set<std::size_t> expected {};
+    for (std::size_t i = 0; i < array_triangle.size (); ++i)
+        for (std::size_t j = i + 1; j < array_triangle.size (); ++j)
+            if (array_triangle[i].check_intersection (array_triangle[j], kernel_t::robust))
+            {
+                expected.insert (i);
+                expected.insert (j);
+            }
+
+    octree_t tree (array_triangle);
+    tree.set_kernel (kernel_t::robust);
+    EXPECT_EQ (tree.get_num_tr_intersection (), expected);
+    EXPECT_EQ (tree.get_num_tr_intersection (), octree_t (array_triangle).get_num_tr_intersection ());
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_GUIGUE_DEVILLERS----------------------------
+
+TEST (intersection_guigue_devillers, touching)
+{
+    triangle_t tr ({ 0, 0, 0 }, { 2, 0, 0 }, { 0, 2, 0 });
+    triangle_t vertex ({ 1, 1, 0 }, { 1, 1, 1 }, { 2, 2, 1 });
+    triangle_t edge ({ 0, 0, 0 }, { 2, 0, 0 }, { 1, 0, 1 });
+    triangle_t crossing ({ 0.5, 0.5, -1 }, { 0.5, 0.5, 1 }, { 1, 0.5, 1 });
+    triangle_t apart ({ 1.5, 1.5, -1 }, { 1.5, 1.5, 1 }, { 2, 1.5, 1 });
+
+    // every order of the vertices of both triangles
+    for (int i = 0; i < 2; ++i)
+    {
+        EXPECT_TRUE (tr.check_intersection (vertex, kernel_t::guigue_devillers));
+        EXPECT_TRUE (vertex.check_intersection (tr, kernel_t::guigue_devillers));
+        EXPECT_TRUE (tr.check_intersection (edge, kernel_t::guigue_devillers));
+        EXPECT_TRUE (tr.check_intersection (crossing, kernel_t::guigue_devillers));
+        EXPECT_FALSE (tr.check_intersection (apart, kernel_t::guigue_devillers));
+        EXPECT_FALSE (apart.check_intersection (tr, kernel_t::guigue_devillers));
+
+        tr = triangle_t (tr.get_a (), tr.get_c (), tr.get_b ());
+        apart = triangle_t (apart.get_b (), apart.get_a (), apart.get_c ());
+        crossing = triangle_t (crossing.get_c (), crossing.get_a (), crossing.get_b ());
+    }
+}
+
+TEST (intersection_guigue_devillers, same_as_robust)
+{
+    // small integer coordinates give every kind of touching and coplanar pairs
+    std::mt19937 gen (7);
+    std::uniform_int_distribution<int> coord (0, 3);
+    auto random_point = [&] () { return point_t (coord (gen), coord (gen), coord (gen)); };
+
+    for (std::size_t i = 0; i < 20000; ++i)
+    {
+        triangle_t tr1 (random_point (), random_point (), random_point ());
+        triangle_t tr2 (random_point (), random_point (), random_point ());
+        ASSERT_EQ (tr1.check_intersection (tr2, kernel_t::guigue_devillers),
+                   tr1.check_intersection (tr2, kernel_t::robust));
+    }
+}
+
+TEST (octree, guigue_devillers_kernel)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (2000, 50.0, 2.0, 13);
+
+    octree_t tree (array_triangle);
+    tree.set_kernel (kernel_t::guigue_devillers);
+    octree_t robust_tree (array_triangle);
+    robust_tree.set_kernel (kernel_t::robust);
+    EXPECT_EQ (tree.get_num_tr_intersection (), robust_tree.get_num_tr_intersection ());
+}
+
+TEST (kernel, names)
+{
+    for (auto kernel : ALL_KERNELS)
+    {
+        kernel_t parsed = kernel_t::epsilon;
+        EXPECT_TRUE (kernel_from_name (kernel_name (kernel), parsed));
+        EXPECT_EQ (parsed, kernel);
+    }
+
+    kernel_t parsed = kernel_t::robust;
+    EXPECT_FALSE (kernel_from_name ("fast", parsed));
+    EXPECT_EQ (parsed, kernel_t::robust);
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_SCALAR_TYPES--------------------------------
+
+template <typename T>
+class scalar_types : public ::testing::Test { };
+
+using all_scalar_types = ::testing::Types<float, double, long double>;
+TYPED_TEST_SUITE (scalar_types, all_scalar_types);
+
+TYPED_TEST (scalar_types, intersection)
+{
+    using triangle = basic_triangle_t<TypeParam>;
+
+    triangle tr ({ 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 });
+    triangle crossing ({ 0.25, 0.25, -1 }, { 0.25, 0.25, 1 }, { 0.5, 0.25, 1 });
+    triangle apart ({ 0.25, 0.25, 0.5 }, { 0.25, 0.25, 1 }, { 0.5, 0.25, 1 });
+    triangle coplanar ({ 0.5, 0.5, 0 }, { 2, 0.5, 0 }, { 0.5, 2, 0 });
+    triangle point ({ 0.5, 0, 0 }, { 0.5, 0, 0 }, { 0.5, 0, 0 });
+    triangle line ({ -1, 0.5, 0 }, { 2, 0.5, 0 }, { 0.5, 0.5, 0 });
+
+    for (auto kernel : ALL_KERNELS)
+    {
+        EXPECT_TRUE (tr.check_intersection (crossing, kernel));
+        EXPECT_FALSE (tr.check_intersection (apart, kernel));
+        EXPECT_TRUE (tr.check_intersection (coplanar, kernel));
+        EXPECT_TRUE (tr.check_intersection (point, kernel));
+        EXPECT_TRUE (tr.check_intersection (line, kernel));
+        EXPECT_FALSE (apart.check_intersection (line, kernel));
+    }
+}
+
+TYPED_TEST (scalar_types, octree_naive)
+{
+    std::vector<basic_triangle_t<TypeParam>> array_triangle {};
+    for (const auto& tr : generate_triangles (1000, 30.0, 2.0, 17))
+    {
+        auto convert = [] (const point_t& p)
+        {
+            return basic_point_t<TypeParam> (p.x_, p.y_, p.z_);
+        };
+        array_triangle.push_back ({ convert (tr.get_a ()), convert (tr.get_b ()), convert (tr.get_c ()) });
+    }
+
+    std::set<std::size_t> expected {};
+    for (std::size_t i = 0; i < array_triangle.size (); ++i)
+        for (std::size_t j = i + 1; j < array_triangle.size (); ++j)
+            if (array_triangle[i].check_intersection (array_triangle[j]))
+            {
+                expected.insert (i);
+                expected.insert (j);
+            }
+
+    basic_octree_t<TypeParam> tree (array_triangle);
+    EXPECT_FALSE (expected.empty ());
+    EXPECT_EQ (tree.get_num_tr_intersection (), expected);
+}
+
+TEST (scalar_types, tolerance_and_size)
+{
+    EXPECT_EQ (triangle_t::EPSILON, EPSILON);
+    EXPECT_GT (basic_triangle_t<float>::EPSILON, EPSILON);
+    EXPECT_LT (basic_triangle_t<long double>::EPSILON, EPSILON);
+    EXPECT_EQ (2 * sizeof (basic_point_t<float>), sizeof (point_t));
+    EXPECT_LT (sizeof (basic_triangle_t<float>), sizeof (triangle_t));
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_SERVER--------------------------------------
+
+// the numbers of the ok response to the next request, checks the latency field
+static std::vector<std::size_t> read_response (std::istream& in)
+{
+    std::string status;
+    long latency = -1;
+    std::size_t num_lines = 0;
+    in >> status >> latency >> num_lines;
+    EXPECT_EQ (status, "ok");
+    EXPECT_GE (latency, 0);
+
+    std::vector<std::size_t> answer (num_lines);
+    for (auto& tmp : answer)
+        in >> tmp;
+    return answer;
+}
+
+TEST (server, edits_and_queries)
+{
+    std::stringstream in ("scene a 3\n"
+                          "0 0 0  1 0 0  0 1 0\n"
+                          "0.2 0.2 -1  0.2 0.2 1  0.3 0.3 1\n"
+                          "5 5 5  6 5 5  5 6 5\n"
+                          "query a\n"
+                          "query a\n"
+                          "add a 1  5.2 5.2 4  5.2 5.2 6  5.3 5.3 6\n"
+                          "query a\n"
+                          "remove a 0\n"
+                          "query a\n"
+                          "set a 0  0 0 0  0 0 0  0 0 0\n"
+                          "query_triangle a  5.2 5.2 4  5.2 5.2 6  5.3 5.3 6\n"
+                          "quit\n"
+                          "query a\n");
+    std::stringstream out;
+
+    thread_pool_t pool (2);
+    server_t server (pool);
+    EXPECT_TRUE (server.serve (in, out));
+
+    EXPECT_EQ (read_response (out), std::vector<std::size_t> { 3 });
+    EXPECT_EQ (read_response (out), (std::vector<std::size_t> { 0, 1 }));
+    EXPECT_EQ (read_response (out), (std::vector<std::size_t> { 0, 1 }));
+    EXPECT_EQ (read_response (out), std::vector<std::size_t> { 4 });
+    EXPECT_EQ (read_response (out), (std::vector<std::size_t> { 0, 1, 2, 3 }));
+    EXPECT_EQ (read_response (out), std::vector<std::size_t> { 3 });
+    EXPECT_EQ (read_response (out), (std::vector<std::size_t> { 1, 2 }));
+    EXPECT_EQ (read_response (out), std::vector<std::size_t> { 3 });
+    EXPECT_EQ (read_response (out), (std::vector<std::size_t> { 1, 2 }));
+
+    std::string rest;
+    out >> rest;
+    EXPECT_TRUE (out.eof ());
+}
+
+TEST (server, errors)
+{
+    std::stringstream in ("query b\n"
+                          "scene b 1  0 0 0  1 0 0  0 1 0\n"
+                          "remove b 5\n"
+                          "stats b\n"
+                          "drop b\n"
+                          "query b\n"
+                          "scene b 2  0 0 0  1 0 0\n");
+    std::stringstream out;
+
+    thread_pool_t pool (2);
+    server_t server (pool, kernel_t::robust);
+    EXPECT_FALSE (server.serve (in, out));
+
+    std::vector<std::string> status;
+    for (std::string line; std::getline (out, line);)
+        status.push_back (line.substr (0, line.find (' ')));
+
+    std::vector<std::string> expected { "error", "ok", "1", "error", "error", "ok", "error", "error" };
+    EXPECT_EQ (status, expected);
+    EXPECT_EQ (server.get_num_scenes (), 0);
+}
+
+// a count of triangles that does not fit into memory or into std::size_t with the
+// coordinates ends the session, not the server
+TEST (server, too_many_triangles)
+{
+    thread_pool_t pool (2);
+    server_t server (pool);
+    for (std::string num : { "3000000000000", "4611686018427387904" })
+    {
+        std::stringstream in ("scene a " + num + "\n0 0 0  1 0 0  0 1 0\n");
+        std::stringstream out;
+        EXPECT_FALSE (server.serve (in, out));
+        EXPECT_EQ (out.str (), "error 0 cannot allocate " + num + " triangles\n");
+    }
+
+    std::stringstream in ("scene a 1  0 0 0  1 0 0  0 1 0\nquit\n");
+    std::stringstream out;
+    EXPECT_TRUE (server.serve (in, out));
+    EXPECT_EQ (read_response (out), std::vector<std::size_t> { 1 });
+}
+
+TEST (server, same_as_octree)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (3000, 40.0, 2.0, 41);
+
+    std::stringstream in;
+    in.precision (17);
+    in << "scene s " << array_triangle.size () << "\n";
+    for (const auto& tr : array_triangle)
+        in << tr.get_a ().x_ << " " << tr.get_a ().y_ << " " << tr.get_a ().z_ << " "
+           << tr.get_b ().x_ << " " << tr.get_b ().y_ << " " << tr.get_b ().z_ << " "
+           << tr.get_c ().x_ << " " << tr.get_c ().y_ << " " << tr.get_c ().z_ << "\n";
+    in << "query s\n";
+
+    std::stringstream out;
+    thread_pool_t pool (3);
+    server_t server (pool);
+    server.serve (in, out);
+    read_response (out);
+
+    octree_t tree (array_triangle);
+    std::set<std::size_t> expected = tree.get_num_tr_intersection ();
+    EXPECT_EQ (read_response (out), std::vector<std::size_t> (expected.begin (), expected.end ()));
+}
+
+// a client of the unix socket at path, -1 if the server does not listen in a second
+static int connect_unix_socket (const std::string& path)
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    std::strcpy (address.sun_path, path.c_str ());
+
+    for (int attempt = 0; attempt < 1000; ++attempt)
+    {
+        int fd = ::socket (AF_UNIX, SOCK_STREAM, 0);
+        if (::connect (fd, reinterpret_cast<sockaddr*> (&address), sizeof (address)) == 0)
+            return fd;
+
+        ::close (fd);
+        std::this_thread::sleep_for (std::chrono::milliseconds (1));
+    }
+    return -1;
+}
+
+static void send_all (int fd, const std::string& data)
+{
+    for (std::size_t sent = 0; sent < data.size ();)
+    {
+        ssize_t num = ::send (fd, data.data () + sent, data.size () - sent, MSG_NOSIGNAL);
+        ASSERT_GT (num, 0);
+        sent += num;
+    }
+}
+
+// a client that leaves before its response does not stop the server
+TEST (server, client_gone)
+{
+    std::string path = testing::TempDir () + "/triangles_server_test.sock";
+    thread_pool_t pool (2);
+    server_t server (pool);
+    bool served = false;
+    std::thread daemon ([&]
+    {
+        served = serve_unix_socket (path, [&] (std::istream& in, std::ostream& out) { return server.serve (in, out); });
+    });
+
+    std::vector<triangle_t> array_triangle = generate_triangles (20000, 40.0, 2.0, 54);
+    std::stringstream request;
+    request << "scene a " << array_triangle.size () << "\n";
+    for (const auto& tr : array_triangle)
+    {
+        for (const point_t& p : { tr.get_a (), tr.get_b (), tr.get_c () })
+            request << p.x_ << " " << p.y_ << " " << p.z_ << " ";
+        request << "\n";
+    }
+    request << "query a\n";
+
+    int gone = connect_unix_socket (path);
+    ASSERT_GE (gone, 0);
+    send_all (gone, request.str ());
+    ::close (gone);
+
+    int client = connect_unix_socket (path);
+    ASSERT_GE (client, 0);
+    send_all (client, "quit\n");
+    daemon.join ();
+    ::close (client);
+
+    EXPECT_TRUE (served);
+    EXPECT_EQ (server.get_num_scenes (), 1u);
+}
+
+// a file at the path of the socket is not removed, the server does not start
+TEST (server, path_not_socket)
+{
+    std::string path = testing::TempDir () + "/triangles_server_test.txt";
+    std::FILE* file = std::fopen (path.c_str (), "w");
+    ASSERT_NE (file, nullptr);
+    std::fputs ("data\n", file);
+    std::fclose (file);
+
+    EXPECT_FALSE (serve_unix_socket (path, [] (std::istream&, std::ostream&) { return true; }));
+
+    file = std::fopen (path.c_str (), "r");
+    ASSERT_NE (file, nullptr);
+    char buffer[16] {};
+    EXPECT_NE (std::fgets (buffer, sizeof (buffer), file), nullptr);
+    EXPECT_STREQ (buffer, "data\n");
+    std::fclose (file);
+    std::remove (path.c_str ());
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_OUTPUT--------------------------------------
+
+TEST (output, formats)
+{
+    std::vector<unsigned char> flags { 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 1 };
+
+    std::vector<char> text {};
+    EXPECT_TRUE (format_intersections (flags, output_format_t::text, text));
+    EXPECT_EQ (std::string (text.begin (), text.end ()), "1\n9\n10\n");
+
+    std::vector<char> packed {};
+    EXPECT_TRUE (format_intersections (flags, output_format_t::uint32, packed));
+    ASSERT_EQ (packed.size (), 3 * sizeof (std::uint32_t));
+    std::uint32_t nums[3] {};
+    std::memcpy (nums, packed.data (), packed.size ());
+    EXPECT_EQ (nums[0], 1u);
+    EXPECT_EQ (nums[1], 9u);
+    EXPECT_EQ (nums[2], 10u);
+
+    std::vector<char> bitmap {};
+    EXPECT_TRUE (format_intersections (flags, output_format_t::bitmap, bitmap));
+    ASSERT_EQ (bitmap.size (), 2);
+    EXPECT_EQ (static_cast<unsigned char> (bitmap[0]), 0x02);
+    EXPECT_EQ (static_cast<unsigned char> (bitmap[1]), 0x06);
+
+    output_format_t format = output_format_t::text;
+    EXPECT_TRUE (output_format_from_name ("bitmap", format));
+    EXPECT_EQ (format, output_format_t::bitmap);
+    EXPECT_FALSE (output_format_from_name ("json", format));
+}
+
+TEST (output, flags_of_octree)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (4000, 30.0, 2.0, 44);
+    thread_pool_t pool (3);
+    octree_t tree (array_triangle, pool);
+
+    std::vector<unsigned char> flags = tree.get_intersection_flags (pool);
+    ASSERT_EQ (flags.size (), array_triangle.size ());
+
+    std::set<std::size_t> expected = tree.get_num_tr_intersection ();
+    std::string expected_text {};
+    for (auto tmp : expected)
+        expected_text += std::to_string (tmp) + "\n";
+
+    std::vector<char> text {};
+    format_intersections (flags, output_format_t::text, text);
+    EXPECT_EQ (std::string (text.begin (), text.end ()), expected_text);
+    EXPECT_EQ (tree.get_num_tr_intersection (pool), expected);
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_BATCH---------------------------------------
+
+static std::vector<unsigned char> naive_flags (const std::vector<triangle_t>& array_triangle, kernel_t kernel)
+{
+    std::vector<unsigned char> flags (array_triangle.size ());
+    for (std::size_t i = 0; i < array_triangle.size (); ++i)
+        for (std::size_t j = i + 1; j < array_triangle.size (); ++j)
+            if (array_triangle[i].check_intersection (array_triangle[j], kernel))
+            {
+                flags[i] = 1;
+                flags[j] = 1;
+            }
+    return flags;
+}
+
+TEST (batch, naive_same_as_loop)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (500, 15.0, 2.0, 45);
+    for (auto kernel : ALL_KERNELS)
+        EXPECT_EQ (get_intersection_flags_naive (array_triangle, kernel), naive_flags (array_triangle, kernel));
+
+    // boxes a bit less than EPSILON apart
+    std::vector<triangle_t> touching { { point_t (0, 0, 0), point_t (1, 0, 0), point_t (0, 1, 0) },
+                                       { point_t (0.2, 0.2, 0.5 * EPSILON), point_t (1, 0.2, 1),
+                                         point_t (0.2, 1, 1) } };
+    EXPECT_EQ (get_intersection_flags_naive (touching, kernel_t::epsilon), (std::vector<unsigned char> { 1, 1 }));
+    EXPECT_EQ (get_intersection_flags_naive (touching, kernel_t::epsilon), naive_flags (touching, kernel_t::epsilon));
+
+    // small triangles, where the tolerance of the epsilon kernel is not a distance
+    std::vector<triangle_t> near_miss = near_miss_triangles ();
+    for (auto kernel : ALL_KERNELS)
+        EXPECT_EQ (get_intersection_flags_naive (near_miss, kernel), naive_flags (near_miss, kernel)) << kernel_name (kernel);
+}
+
+TEST (batch, same_as_octree)
+{
+    std::vector<std::vector<triangle_t>> scenes {};
+    for (std::size_t N : std::vector<std::size_t> { 0, 1, 7, 100, 128, 129, 900, 3000, BATCH_SPLIT_MIN_TRIANGLES + 1 })
+        scenes.push_back (generate_triangles (N, 2.0 * std::cbrt (N + 1.0), 2.0, 46 + N));
+
+    thread_pool_t pool (4);
+    std::vector<std::vector<unsigned char>> flags = get_batch_intersection_flags (scenes, pool);
+    ASSERT_EQ (flags.size (), scenes.size ());
+
+    for (std::size_t i = 0; i < scenes.size (); ++i)
+    {
+        octree_t tree (scenes[i]);
+        EXPECT_EQ (flags[i], tree.get_intersection_flags ()) << "scene of " << scenes[i].size ();
+    }
+}
+
+// the engine is the one asked for every scene, the large ones too
+TEST (batch, engine_of_every_scene)
+{
+    std::vector<std::vector<triangle_t>> scenes { near_miss_triangles (),
+                                                  generate_triangles (BATCH_SPLIT_MIN_TRIANGLES, 60.0, 2.0, 52) };
+    std::vector<std::vector<unsigned char>> expected {};
+    for (auto& scene : scenes)
+    {
+        octree_t tree (scene);
+        tree.set_kernel (kernel_t::epsilon);
+        expected.push_back (tree.get_intersection_flags ());
+    }
+
+    thread_pool_t pool (2);
+    for (auto engine : ALL_ENGINES)
+        EXPECT_EQ (get_batch_intersection_flags (scenes, pool, kernel_t::epsilon, engine), expected)
+            << engine_name (engine);
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_ENGINE--------------------------------------
+
+TEST (engine, selection)
+{
+    engine_calibration_t calibration {};
+    calibration.naive_max_triangles_ = 100;
+    EXPECT_EQ (select_engine (engine_t::automatic, 100, calibration), engine_t::naive);
+    EXPECT_EQ (select_engine (engine_t::automatic, 101, calibration), engine_t::octree);
+    EXPECT_EQ (select_engine (engine_t::naive, 5000, calibration), engine_t::naive);
+    EXPECT_EQ (select_engine (engine_t::octree, 5, calibration), engine_t::octree);
+
+    for (auto engine : ALL_ENGINES)
+    {
+        engine_t parsed = engine_t::octree;
+        EXPECT_TRUE (engine_from_name (engine_name (engine), parsed));
+        EXPECT_EQ (parsed, engine);
+    }
+}
+
+TEST (engine, same_flags)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (1500, 20.0, 2.0, 47);
+    engine_calibration_t calibration {};
+
+    thread_pool_t pool (3);
+    std::vector<unsigned char> expected = get_intersection_flags (array_triangle, engine_t::octree, calibration);
+    EXPECT_EQ (get_intersection_flags (array_triangle, engine_t::naive, calibration), expected);
+    EXPECT_EQ (get_intersection_flags (array_triangle, pool, engine_t::automatic, calibration), expected);
+}
+
+// the epsilon kernel reaches no farther than kernel_margin, so every engine checks
+// every pair it may report
+TEST (engine, near_miss_same_flags)
+{
+    std::vector<triangle_t> array_triangle = near_miss_triangles ();
+    engine_calibration_t calibration {};
+    thread_pool_t pool (3);
+
+    for (auto kernel : ALL_KERNELS)
+    {
+        std::vector<unsigned char> expected = naive_flags (array_triangle, kernel);
+        EXPECT_EQ (get_intersection_flags (array_triangle, engine_t::naive, calibration, kernel), expected)
+            << kernel_name (kernel);
+        EXPECT_EQ (get_intersection_flags (array_triangle, engine_t::octree, calibration, kernel), expected)
+            << kernel_name (kernel);
+        EXPECT_EQ (get_intersection_flags (array_triangle, engine_t::automatic, calibration, kernel), expected)
+            << kernel_name (kernel);
+        EXPECT_EQ (get_intersection_flags (array_triangle, pool, engine_t::octree, calibration, kernel), expected)
+            << kernel_name (kernel);
+    }
+
+    // touching pairs are reported, pairs farther apart than EPSILON are not
+    std::vector<unsigned char> flags = get_intersection_flags (array_triangle, engine_t::octree, calibration,
+                                                               kernel_t::epsilon);
+    for (std::size_t i = 0; i < flags.size (); i += 2)
+    {
+        double gap = NEAR_MISS_GAPS[i / 2 / NEAR_MISS_LAYOUTS % 9];
+        if (gap == 0)
+            EXPECT_EQ (flags[i], 1) << "pair " << i / 2;
+        else if (gap > EPSILON)
+            EXPECT_EQ (flags[i], 0) << "pair " << i / 2;
+    }
+}
+
+TEST (engine, calibration)
+{
+    engine_calibration_t calibration = calibrate_engine<double> ();
+    EXPECT_LE (calibration.naive_max_triangles_, CALIBRATION_MAX_N);
+
+    std::string path = ::testing::TempDir () + "triangles_calibration.txt";
+    ASSERT_TRUE (save_calibration (path, calibration));
+
+    engine_calibration_t loaded {};
+    loaded.naive_max_triangles_ = calibration.naive_max_triangles_ + 1;
+    ASSERT_TRUE (load_calibration (path, loaded));
+    EXPECT_EQ (loaded.naive_max_triangles_, calibration.naive_max_triangles_);
+    EXPECT_FALSE (load_calibration (path + ".missing", loaded));
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_REORDER-------------------------------------
+
+TEST (reorder, morton_code)
+{
+    EXPECT_EQ (morton_code (0, 0, 0), 0u);
+    EXPECT_EQ (morton_code (1, 0, 0), 1u);
+    EXPECT_EQ (morton_code (0, 1, 0), 2u);
+    EXPECT_EQ (morton_code (0, 0, 1), 4u);
+    EXPECT_EQ (morton_code (3, 3, 3), 63u);
+    EXPECT_EQ (morton_code ((1 << MORTON_BITS) - 1, (1 << MORTON_BITS) - 1, (1 << MORTON_BITS) - 1),
+               (std::uint64_t (1) << (3 * MORTON_BITS)) - 1);
+}
+
+TEST (reorder, same_flags)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (20000, 60.0, 2.0, 48);
+    std::vector<unsigned char> expected = octree_t (array_triangle).get_intersection_flags ();
+
+    thread_pool_t pool (3);
+    std::vector<triangle_t> reordered = array_triangle;
+    std::vector<std::size_t> order = reorder_morton (reordered, pool);
+
+    std::vector<std::size_t> sorted = order;
+    std::sort (sorted.begin (), sorted.end ());
+    for (std::size_t num = 0; num < sorted.size (); ++num)
+        ASSERT_EQ (sorted[num], num);
+    for (std::size_t num = 0; num < order.size (); ++num)
+        ASSERT_EQ (reordered[num].get_a (), array_triangle[order[num]].get_a ());
+
+    octree_t tree (reordered, pool);
+    EXPECT_EQ (restore_order (tree.get_intersection_flags (pool), order), expected);
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_GATHER--------------------------------------
+
+TEST (gather, same_pairs)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (5000, 30.0, 2.0, 49);
+    for (auto kernel : ALL_KERNELS)
+    {
+        octree_t tree (array_triangle);
+        tree.set_kernel (kernel);
+        std::vector<std::pair<std::size_t, std::size_t>> expected {};
+        tree.for_each_intersecting_pair ([&] (std::size_t num_1, std::size_t num_2)
+        {
+            expected.push_back ({ num_1, num_2 });
+            return true;
+        });
+
+        tree.set_gather_leaves (true);
+        std::vector<std::pair<std::size_t, std::size_t>> gathered {};
+        tree.for_each_intersecting_pair ([&] (std::size_t num_1, std::size_t num_2)
+        {
+            gathered.push_back ({ num_1, num_2 });
+            return true;
+        });
+        EXPECT_EQ (gathered, expected) << kernel_name (kernel);
+
+        thread_pool_t pool (3);
+        EXPECT_EQ (tree.get_intersection_flags (pool), octree_t (array_triangle).get_intersection_flags ());
+    }
+}
+
+// the box filter of the buffer is the one of the kernel, pairs closer than its reach
+// are still checked
+TEST (gather, near_miss)
+{
+    std::vector<triangle_t> array_triangle = near_miss_triangles ();
+    for (auto kernel : ALL_KERNELS)
+    {
+        octree_t tree (array_triangle);
+        tree.set_kernel (kernel);
+        std::vector<unsigned char> expected = tree.get_intersection_flags ();
+        EXPECT_EQ (expected, naive_flags (array_triangle, kernel)) << kernel_name (kernel);
+
+        tree.set_gather_leaves (true);
+        EXPECT_EQ (tree.get_intersection_flags (), expected) << kernel_name (kernel);
+    }
+}
+
+// a leaf larger than the buffer takes the indexed loop
+TEST (gather, large_leaf)
+{
+    std::size_t N = LEAF_BUFFER_CAPACITY + 10;
+    std::vector<triangle_t> array_triangle (N, triangle_t ({ 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }));
+    array_triangle.push_back (triangle_t ({ 5, 5, 5 }, { 6, 5, 5 }, { 5, 6, 5 }));
+
+    octree_t tree (array_triangle);
+    tree.set_gather_leaves (true);
+    EXPECT_EQ (tree.get_num_tr_intersection ().size (), N);
+}
+
+// the buffer of the thread is busy during the callback, a query from it is not gathered
+TEST (gather, nested_query)
+{
+    std::vector<triangle_t> array_triangle { triangle_t ({ 0, 0, 0 }, { 1, 0, 0 }, { 0, 1, 0 }),
+                                             triangle_t ({ 0, 0, -1 }, { 0, 0, 1 }, { 1, 1, 0 }),
+                                             triangle_t ({ 0.2, 0.2, -1 }, { 0.2, 0.2, 1 }, { 1, 0, 0 }) };
+    std::vector<triangle_t> other_triangle { triangle_t ({ 5, 5, 5 }, { 6, 5, 5 }, { 5, 6, 5 }),
+                                             triangle_t ({ 5, 5, 7 }, { 6, 5, 7 }, { 5, 6, 7 }) };
+    octree_t tree (array_triangle);
+    octree_t other (other_triangle);
+    tree.set_gather_leaves (true);
+    other.set_gather_leaves (true);
+
+    std::vector<std::pair<std::size_t, std::size_t>> pairs {};
+    tree.for_each_intersecting_pair ([&] (std::size_t num_1, std::size_t num_2)
+    {
+        pairs.push_back ({ num_1, num_2 });
+        EXPECT_TRUE (other.get_num_tr_intersection ().empty ());
+        return true;
+    });
+    EXPECT_EQ (pairs, (std::vector<std::pair<std::size_t, std::size_t>> { { 0, 1 }, { 0, 2 }, { 1, 2 } }));
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_NUMA----------------------------------------
+
+TEST (numa, init_worker)
+{
+    std::atomic<std::size_t> num_started { 0 };
+    {
+        thread_pool_t pool (4, [&] { num_started++; });
+        std::atomic<std::size_t> sum { 0 };
+        pool.parallel_for (0, 100, [&] (std::size_t i) { sum += i; });
+        EXPECT_EQ (sum, 4950u);
+    }
+    EXPECT_EQ (num_started, 3u);
+}
+
+TEST (numa, simulated_topology)
+{
+    std::vector<int> cpus = simulated_numa_topology (1).cpus_.front ();
+    ASSERT_FALSE (cpus.empty ());
+
+    numa_topology_t topology = simulated_numa_topology (3);
+    ASSERT_EQ (topology.get_num_nodes (), 3u);
+    std::vector<int> joined {};
+    for (const auto& node : topology.cpus_)
+        joined.insert (joined.end (), node.begin (), node.end ());
+    EXPECT_EQ (joined, cpus);
+
+    std::size_t num_cpus = 0;
+    for (const auto& node : detect_numa_topology ().cpus_)
+        num_cpus += node.size ();
+    EXPECT_EQ (num_cpus, cpus.size ());
+
+    EXPECT_FALSE (pin_current_thread ({}));
+    std::thread pinned ([&] { EXPECT_TRUE (pin_current_thread ({ cpus.front () })); });
+    pinned.join ();
+}
+
+// the triangles crossing the slab boundaries belong to both slabs
+static std::vector<double> triangle_coords (const std::vector<triangle_t>& array_triangle)
+{
+    std::vector<double> coords {};
+    for (const auto& tr : array_triangle)
+    {
+        for (const point_t& p : { tr.get_a (), tr.get_b (), tr.get_c () })
+        {
+            coords.push_back (p.x_);
+            coords.push_back (p.y_);
+            coords.push_back (p.z_);
+        }
+    }
+    return coords;
+}
+
+// The pairs of near_miss_triangles whose gap straddles x = 0, moved to x = 0.3, off the
+// planes of the octree cells, and three triangles that make x the longest axis and the
+// median center x = 0.3: two slabs along x meet in the gaps of the pairs.
+static std::vector<triangle_t> straddling_near_misses ()
+{
+    point_t shift (0.3, 0, 0);
+    std::vector<triangle_t> near_miss = near_miss_triangles ();
+    std::vector<triangle_t> array_triangle {};
+    for (std::size_t i = 0; i < near_miss.size (); ++i)
+    {
+        const triangle_t& tr = near_miss[i];
+        if (i / 2 % NEAR_MISS_LAYOUTS != 1)
+            array_triangle.push_back ({ tr.get_a () + shift, tr.get_b () + shift, tr.get_c () + shift });
+    }
+
+    for (double x : { -10.0, 10.0 })
+        array_triangle.push_back ({ point_t (x, 5, 0), point_t (x + 0.01, 5, 0), point_t (x, 5.01, 0) });
+    array_triangle.push_back ({ point_t (0.3, 5, 0), point_t (0.3, 5.01, 0), point_t (0.3, 5, 0.01) });
+    return array_triangle;
+}
+
+TEST (numa, same_flags)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (6000, 30.0, 3.0, 50);
+    std::vector<double> coords = triangle_coords (array_triangle);
+
+    for (auto kernel : ALL_KERNELS)
+    {
+        octree_t tree (array_triangle);
+        tree.set_kernel (kernel);
+        std::vector<unsigned char> expected = tree.get_intersection_flags ();
+
+        for (std::size_t num_nodes : { 1, 2, 3, 5 })
+        {
+            numa_pool_t numa_pool (simulated_numa_topology (num_nodes), 2 * num_nodes);
+            EXPECT_EQ (get_numa_intersection_flags (coords, numa_pool, kernel, num_nodes % 2 == 1), expected)
+                << kernel_name (kernel) << " " << num_nodes;
+        }
+    }
+
+    // every triangle is in the tree of at least one node, the hits are those of the trees
+    numa_pool_t numa_pool (simulated_numa_topology (3));
+    std::vector<octree_stats_t> node_stats {};
+    std::vector<unsigned char> flags = get_numa_intersection_flags (coords, numa_pool, kernel_t::epsilon, false,
+                                                                    &node_stats);
+    ASSERT_EQ (node_stats.size (), 3u);
+    std::size_t num_triangles = 0;
+    std::size_t num_hits = 0;
+    for (const auto& stats : node_stats)
+    {
+        num_triangles += stats.num_triangles_;
+        num_hits += stats.num_hits_;
+    }
+    EXPECT_GE (num_triangles, array_triangle.size ());
+    EXPECT_GE (num_hits, static_cast<std::size_t> (std::count (flags.begin (), flags.end (), 1)) / 2);
+
+    EXPECT_TRUE (get_numa_intersection_flags (std::vector<double> {}, numa_pool).empty ());
+}
+
+// the slabs are widened by the reach of the kernel, a pair split by a boundary meets
+TEST (numa, near_miss)
+{
+    std::vector<triangle_t> array_triangle = straddling_near_misses ();
+    std::vector<double> coords = triangle_coords (array_triangle);
+    std::vector<std::vector<double>> centers {};
+    for (std::size_t num = 0; num < array_triangle.size (); ++num)
+        add_slab_sample (coords.data () + 9 * num, centers);
+    int axis = -1;
+    ASSERT_EQ (slab_bounds (centers, 2, axis), std::vector<double> { 0.3 });
+    ASSERT_EQ (axis, 0);
+
+    numa_pool_t numa_pool (simulated_numa_topology (2), 2);
+    for (auto kernel : ALL_KERNELS)
+    {
+        octree_t tree (array_triangle);
+        tree.set_kernel (kernel);
+        std::vector<unsigned char> expected = tree.get_intersection_flags ();
+        EXPECT_GT (std::count (expected.begin (), expected.end (), 1), 0) << kernel_name (kernel);
+        EXPECT_EQ (get_numa_intersection_flags (coords, numa_pool, kernel), expected) << kernel_name (kernel);
+    }
+}
+
+// ----------------------------------------------------------------------------------
+
+// ------------------------------TESTING_OUT_OF_CORE---------------------------------
+
+static std::string read_file (std::FILE* file)
+{
+    std::string content {};
+    std::rewind (file);
+    char buffer[4096];
+    for (std::size_t size = 0; (size = std::fread (buffer, 1, sizeof (buffer), file)) > 0;)
+        content.append (buffer, size);
+    return content;
+}
+
+static std::string scene_input (const std::vector<triangle_t>& array_triangle)
+{
+    std::stringstream input {};
+    input.precision (17);
+    input << array_triangle.size () << "\n";
+    for (const auto& tr : array_triangle)
+    {
+        for (const point_t& p : { tr.get_a (), tr.get_b (), tr.get_c () })
+            input << p.x_ << " " << p.y_ << " " << p.z_ << " ";
+        input << "\n";
+    }
+    return input.str ();
+}
+
+// the numbers one at a time, over the size of the buffer, as format_intersections
+TEST (out_of_core, number_writer)
+{
+    std::mt19937 gen (51);
+    std::vector<unsigned char> flags (20000000);
+    for (std::size_t num = 0; num < flags.size (); num += 1 + gen () % 60)
+        flags[num] = 1;
+
+    for (auto format : { output_format_t::text, output_format_t::uint32, output_format_t::bitmap })
+    {
+        std::FILE* file = std::tmpfile ();
+        ASSERT_NE (file, nullptr);
+        number_writer_t writer (file, format, flags.size ());
+        for (std::size_t num = 0; num < flags.size (); ++num)
+        {
+            if (flags[num])
+            {
+                ASSERT_TRUE (writer.add (num));
+            }
+        }
+        ASSERT_TRUE (writer.finish ());
+
+        std::vector<char> expected {};
+        format_intersections (flags, format, expected);
+        EXPECT_EQ (read_file (file), std::string (expected.begin (), expected.end ())) << output_format_name (format);
+        std::fclose (file);
+    }
+}
+
+// more files than are merged at once, every number is reported once
+TEST (out_of_core, merge_number_files)
+{
+    std::string directory = testing::TempDir ();
+    std::vector<std::string> paths {};
+    std::set<std::uint64_t> expected {};
+    for (std::uint64_t i = 0; i < OUT_OF_CORE_MAX_FANOUT + 44; ++i)
+    {
+        paths.push_back (temporary_file_path (directory));
+        std::FILE* file = std::fopen (paths.back ().c_str (), "wb");
+        ASSERT_NE (file, nullptr);
+        for (std::uint64_t num = i % 7; num < 5000; num += 3 + i % 11)
+        {
+            std::fwrite (&num, sizeof (num), 1, file);
+            expected.insert (num);
+        }
+        std::fclose (file);
+    }
+
+    std::vector<std::uint64_t> merged {};
+    EXPECT_TRUE (merge_number_files (paths, directory, 1 << 12, [&] (std::uint64_t num)
+    {
+        merged.push_back (num);
+        return true;
+    }));
+    EXPECT_EQ (merged, std::vector<std::uint64_t> (expected.begin (), expected.end ()));
+    for (const auto& path : paths)
+        EXPECT_EQ (std::fopen (path.c_str (), "rb"), nullptr);
+}
+
+// the smallest budget cuts the scene into many buckets
+TEST (out_of_core, same_output)
+{
+    std::vector<triangle_t> array_triangle = generate_triangles (20000, 40.0, 2.0, 52);
+    std::string input = scene_input (array_triangle);
+
+    for (auto kernel : { kernel_t::epsilon, kernel_t::robust })
+    {
+        octree_t tree (array_triangle);
+        tree.set_kernel (kernel);
+        std::vector<char> expected {};
+        format_intersections (tree.get_intersection_flags (), output_format_t::text, expected);
+
+        thread_pool_t pool (3);
+        out_of_core_t out_of_core (testing::TempDir (), 0, pool, kernel);
+        std::stringstream in (input);
+        std::FILE* file = std::tmpfile ();
+        ASSERT_NE (file, nullptr);
+        ASSERT_TRUE (out_of_core.run (in, file, output_format_t::text));
+        EXPECT_EQ (read_file (file), std::string (expected.begin (), expected.end ())) << kernel_name (kernel);
+        std::fclose (file);
+
+        const out_of_core_stats_t& stats = out_of_core.get_stats ();
+        EXPECT_EQ (stats.bucket_capacity_, OUT_OF_CORE_MIN_CAPACITY);
+        EXPECT_GT (stats.num_buckets_, 20000 / OUT_OF_CORE_MIN_CAPACITY);
+        EXPECT_LE (stats.max_bucket_triangles_, OUT_OF_CORE_MIN_CAPACITY);
+        EXPECT_GE (stats.num_bucket_triangles_, array_triangle.size ());
+        EXPECT_EQ (stats.num_over_budget_, 0u);
+    }
+}
+
+// triangles that cannot be separated are verified over the budget
+TEST (out_of_core, over_budget)
+{
+    // points at the same place, every one in all the slabs
+    std::vector<triangle_t> array_triangle (OUT_OF_CORE_MIN_CAPACITY + 200,
+                                            triangle_t ({ 1, 2, 3 }, { 1, 2, 3 }, { 1, 2, 3 }));
+    std::stringstream in (scene_input (array_triangle));
+
+    thread_pool_t pool (2);
+    out_of_core_t out_of_core (testing::TempDir (), 0, pool);
+    std::FILE* file = std::tmpfile ();
+    ASSERT_NE (file, nullptr);
+    ASSERT_TRUE (out_of_core.run (in, file, output_format_t::bitmap));
+    EXPECT_EQ (read_file (file), std::string ((OUT_OF_CORE_MIN_CAPACITY + 200) / 8, '\xff'));
+    std::fclose (file);
+    EXPECT_EQ (out_of_core.get_stats ().num_over_budget_, 1u);
+}
+
+// the slabs of a split bucket are widened by the reach of the kernel, as those of numa
+TEST (out_of_core, near_miss)
+{
+    // the near misses and as many far triangles on both sides as split the scene into
+    // two buckets at x = 0.3
+    std::vector<triangle_t> array_triangle = straddling_near_misses ();
+    for (int i = 0; i < 550; ++i)
+    {
+        for (double x : { -10.0 - 0.1 * i, 10.0 + 0.1 * i })
+            array_triangle.push_back ({ point_t (x, 5, 1), point_t (x + 0.01, 5, 1), point_t (x, 5.01, 1) });
+    }
+    std::string input = scene_input (array_triangle);
+
+    for (auto kernel : ALL_KERNELS)
+    {
+        octree_t tree (array_triangle);
+        tree.set_kernel (kernel);
+        std::vector<char> expected {};
+        format_intersections (tree.get_intersection_flags (), output_format_t::text, expected);
+
+        thread_pool_t pool (2);
+        out_of_core_t out_of_core (testing::TempDir (), 0, pool, kernel);
+        std::stringstream in (input);
+        std::FILE* file = std::tmpfile ();
+        ASSERT_NE (file, nullptr);
+        ASSERT_TRUE (out_of_core.run (in, file, output_format_t::text));
+        EXPECT_EQ (read_file (file), std::string (expected.begin (), expected.end ())) << kernel_name (kernel);
+        std::fclose (file);
+        EXPECT_EQ (out_of_core.get_stats ().num_buckets_, 2u);
+    }
+}
+
+// an input that ends early or is not a number is an error, not a scene of zeros
+TEST (out_of_core, wrong_input)
+{
+    std::string input = scene_input (generate_triangles (10, 10.0, 1.0, 53));
+    std::string triangles = input.substr (input.find ('\n') + 1);
+    std::vector<std::string> array_wrong { "", "x", input.substr (0, input.size () / 2), "20\n" + triangles,
+                                           "10\nx" + triangles.substr (1) };
+    for (const std::string& wrong : array_wrong)
+    {
+        thread_pool_t pool (1);
+        out_of_core_t out_of_core (testing::TempDir (), 0, pool);
+        std::stringstream in (wrong);
+        std::FILE* file = std::tmpfile ();
+        ASSERT_NE (file, nullptr);
+        EXPECT_FALSE (out_of_core.run (in, file, output_format_t::text)) << wrong;
+        EXPECT_TRUE (in.fail ());
+        EXPECT_EQ (read_file (file), "");
+        std::fclose (file);
+    }
+}
+
+// ----------------------------------------------------------------------------------